@@ -0,0 +1,609 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+// Compares the heap based AStarNodes with the linear scan it replaced on the
+// ground floor of a real map (data/world/forgotten.otbm by default). Both run
+// the search loops of Map::getPathMatching and Map::getPathTo on the same
+// random queries, half bounded to maxSearchDist 12 and half unbounded.
+// Exits with 1 when the map cannot be read or any path differs.
+
+#include "otpch.h"
+#include "map.h"
+#include "creature.h"
+
+#include "otbmtiles.h"
+
+static const uint32_t QUERIES = 20000;
+static const int32_t QUERY_RADIUS = 10;
+static const uint8_t FLOOR_Z = 7;
+
+// AStarNodes before the binary heap, kept as it was apart from the name
+class LegacyAStarNodes
+{
+	public:
+		LegacyAStarNodes(uint32_t)
+		{
+			curNode = 0;
+			openNodes.reset();
+		}
+
+		void openNode(AStarNode* node)
+		{
+			uint32_t pos = node - nodes;
+			if(pos < MAX_NODES)
+				openNodes[pos] = 1;
+		}
+
+		void closeNode(AStarNode* node)
+		{
+			uint32_t pos = node - nodes;
+			if(pos < MAX_NODES)
+				openNodes[pos] = 0;
+		}
+
+		uint32_t countClosedNodes()
+		{
+			uint32_t counter = 0;
+			for(uint32_t i = 0; i < curNode; i++)
+			{
+				if(!openNodes[i])
+					counter++;
+			}
+
+			return counter;
+		}
+
+		AStarNode* getBestNode()
+		{
+			if(!curNode)
+				return NULL;
+
+			int32_t bestNodeF = 100000;
+			uint32_t bestNode = 0;
+
+			bool found = false;
+			for(uint32_t i = 0; i < curNode; i++)
+			{
+				if(nodes[i].f < bestNodeF && openNodes[i] == 1)
+				{
+					found = true;
+					bestNodeF = nodes[i].f;
+					bestNode = i;
+				}
+			}
+
+			if(found)
+				return &nodes[bestNode];
+
+			return NULL;
+		}
+
+		AStarNode* createOpenNode()
+		{
+			if(curNode >= MAX_NODES)
+				return NULL;
+
+			uint32_t retNode = curNode;
+			curNode++;
+
+			openNodes[retNode] = 1;
+			return &nodes[retNode];
+		}
+
+		AStarNode* getNodeInList(uint16_t x, uint16_t y)
+		{
+			for(uint32_t i = 0; i < curNode; i++)
+			{
+				if(nodes[i].x == x && nodes[i].y == y)
+					return &nodes[i];
+			}
+
+			return NULL;
+		}
+
+		int32_t getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal)
+		{
+			int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
+			return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(
+				x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
+		}
+
+		int32_t getMapWalkCost(const Creature*, AStarNode* node,
+			const Tile*, const Position& neighbourPos)
+		{
+			if(std::abs(node->x - neighbourPos.x) == std::abs(node->y - neighbourPos.y)) //diagonal movement extra cost
+				return MAP_DIAGONALWALKCOST;
+
+			return MAP_NORMALWALKCOST;
+		}
+
+	private:
+		AStarNode nodes[MAX_NODES];
+
+		std::bitset<MAX_NODES> openNodes;
+		uint32_t curNode;
+};
+
+// walkable ground tiles, some of them as expensive as a field or a creature
+class GridWalkSource
+{
+	public:
+		void add(uint16_t x, uint16_t y) {m_tiles.insert(((uint32_t)x << 16) | y);}
+
+		bool canWalk(const Position& pos, int32_t& extraCost) const
+		{
+			uint32_t key = ((uint32_t)pos.x << 16) | pos.y;
+			if(m_tiles.find(key) == m_tiles.end())
+				return false;
+
+			extraCost = ((key * 0x9E3779B1U) >> 28) < 2 ? MAP_NORMALWALKCOST * 3 : 0;
+			return true;
+		}
+
+	protected:
+		std::unordered_set<uint32_t> m_tiles;
+};
+
+// FrozenPathingConditionCall without the sight check, which needs the game
+class TargetCondition
+{
+	public:
+		TargetCondition(const Position& _targetPos): targetPos(_targetPos) {}
+
+		bool isInRange(const Position& startPos, const Position& testPos, const FindPathParams& fpp) const
+		{
+			int32_t dxMin = ((fpp.fullPathSearch || (startPos.x - targetPos.x) <= 0) ? fpp.maxTargetDist : 0),
+			dxMax = ((fpp.fullPathSearch || (startPos.x - targetPos.x) >= 0) ? fpp.maxTargetDist : 0),
+			dyMin = ((fpp.fullPathSearch || (startPos.y - targetPos.y) <= 0) ? fpp.maxTargetDist : 0),
+			dyMax = ((fpp.fullPathSearch || (startPos.y - targetPos.y) >= 0) ? fpp.maxTargetDist : 0);
+			if(testPos.x > targetPos.x + dxMax || testPos.x < targetPos.x - dxMin)
+				return false;
+
+			if(testPos.y > targetPos.y + dyMax || testPos.y < targetPos.y - dyMin)
+				return false;
+
+			return true;
+		}
+
+		bool operator()(const Position& startPos, const Position& testPos,
+			const FindPathParams& fpp, int32_t& bestMatchDist) const
+		{
+			if(!isInRange(startPos, testPos, fpp))
+				return false;
+
+			int32_t testDist = std::max(std::abs(targetPos.x - testPos.x), std::abs(targetPos.y - testPos.y));
+			if(fpp.maxTargetDist == 1)
+				return (testDist >= fpp.minTargetDist && testDist <= fpp.maxTargetDist);
+
+			if(testDist <= fpp.maxTargetDist)
+			{
+				if(testDist < fpp.minTargetDist)
+					return false;
+
+				if(testDist == fpp.maxTargetDist)
+				{
+					bestMatchDist = 0;
+					return true;
+				}
+				else if(testDist > bestMatchDist)
+				{
+					bestMatchDist = testDist;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	protected:
+		Position targetPos;
+};
+
+static int32_t neighbourOrderList[8][2] =
+{
+	{-1, 0},
+	{0, 1},
+	{1, 0},
+	{0, -1},
+
+	//diagonal
+	{-1, -1},
+	{1, -1},
+	{1, 1},
+	{-1, 1},
+};
+
+// the loop of findPathMatching in map.cpp
+template<class Nodes>
+static bool findPathMatching(const GridWalkSource& source, const Position& startPos, std::list<Direction>& dirList,
+	const TargetCondition& pathCondition, const FindPathParams& fpp)
+{
+	Position endPos;
+
+	Nodes nodes(fpp.maxNodes);
+	AStarNode* startNode = nodes.createOpenNode();
+
+	startNode->x = startPos.x;
+	startNode->y = startPos.y;
+
+	startNode->f = 0;
+	startNode->parent = NULL;
+	nodes.openNode(startNode);
+
+	dirList.clear();
+	int32_t bestMatch = 0;
+
+	Position pos;
+	pos.z = startPos.z;
+
+	AStarNode* found = NULL;
+	AStarNode* n = NULL;
+
+	int32_t extraCost = 0;
+	while(fpp.maxSearchDist != -1 || nodes.countClosedNodes() < 100)
+	{
+		if(!(n = nodes.getBestNode()))
+		{
+			if(found)
+				break;
+
+			dirList.clear();
+			return false;
+		}
+
+		if(pathCondition(startPos, Position(n->x, n->y, startPos.z), fpp, bestMatch))
+		{
+			found = n;
+			endPos = Position(n->x, n->y, startPos.z);
+			if(!bestMatch)
+				break;
+		}
+
+		int32_t dirCount = (fpp.allowDiagonal ? 8 : 4);
+		for(int32_t i = 0; i < dirCount; ++i)
+		{
+			pos.x = n->x + neighbourOrderList[i][0];
+			pos.y = n->y + neighbourOrderList[i][1];
+
+			bool inRange = true;
+			if(fpp.maxSearchDist != -1 && (std::abs(startPos.x - pos.x) > fpp.maxSearchDist ||
+				std::abs(startPos.y - pos.y) > fpp.maxSearchDist))
+				inRange = false;
+
+			if(fpp.keepDistance)
+			{
+				if(!pathCondition.isInRange(startPos, pos, fpp))
+					inRange = false;
+			}
+
+			if(inRange && source.canWalk(pos, extraCost))
+			{
+				int32_t cost = nodes.getMapWalkCost(NULL, n, NULL, pos),
+					newf = n->f + cost + extraCost;
+
+				AStarNode* neighbourNode = nodes.getNodeInList(pos.x, pos.y);
+				if(neighbourNode)
+				{
+					if(neighbourNode->f <= newf)
+						continue;
+				}
+				else if(!(neighbourNode = nodes.createOpenNode()))
+				{
+					if(found)
+						break;
+
+					dirList.clear();
+					return false;
+				}
+
+				neighbourNode->x = pos.x;
+				neighbourNode->y = pos.y;
+
+				neighbourNode->parent = n;
+				neighbourNode->f = newf;
+				nodes.openNode(neighbourNode);
+			}
+		}
+
+		nodes.closeNode(n);
+	}
+
+	if(!found)
+		return false;
+
+	int32_t prevx = endPos.x, prevy = endPos.y, dx, dy;
+	found = found->parent;
+	while(found)
+	{
+		pos.x = found->x;
+		pos.y = found->y;
+
+		dx = pos.x - prevx;
+		dy = pos.y - prevy;
+
+		prevx = pos.x;
+		prevy = pos.y;
+
+		found = found->parent;
+		if(dx == 1 && dy == 1)
+			dirList.push_front(NORTHWEST);
+		else if(dx == -1 && dy == 1)
+			dirList.push_front(NORTHEAST);
+		else if(dx == 1 && dy == -1)
+			dirList.push_front(SOUTHWEST);
+		else if(dx == -1 && dy == -1)
+			dirList.push_front(SOUTHEAST);
+		else if(dx == 1)
+			dirList.push_front(WEST);
+		else if(dx == -1)
+			dirList.push_front(EAST);
+		else if(dy == 1)
+			dirList.push_front(NORTH);
+		else if(dy == -1)
+			dirList.push_front(SOUTH);
+	}
+
+	return true;
+}
+
+// the loop of Map::getPathTo, searching from the destination back to the start
+template<class Nodes>
+static bool getPathTo(const GridWalkSource& source, const Position& endPos, const Position& destPos,
+	std::list<Direction>& listDir, int32_t maxSearchDist, uint32_t maxNodes)
+{
+	int32_t extraCost = 0;
+	if(!source.canWalk(destPos, extraCost))
+		return false;
+
+	Position startPos = destPos;
+	listDir.clear();
+
+	Nodes nodes(maxNodes);
+	AStarNode* startNode = nodes.createOpenNode();
+
+	startNode->x = startPos.x;
+	startNode->y = startPos.y;
+
+	startNode->g = 0;
+	startNode->h = nodes.getEstimatedDistance(startPos.x, startPos.y, endPos.x, endPos.y);
+
+	startNode->f = startNode->g + startNode->h;
+	startNode->parent = NULL;
+	nodes.openNode(startNode);
+
+	Position pos;
+	pos.z = startPos.z;
+
+	AStarNode* found = NULL;
+	AStarNode* n = NULL;
+	while(maxSearchDist != -1 || nodes.countClosedNodes() < 100)
+	{
+		if(!(n = nodes.getBestNode()))
+		{
+			listDir.clear();
+			return false;
+		}
+
+		if(n->x == endPos.x && n->y == endPos.y)
+		{
+			found = n;
+			break;
+		}
+
+		for(uint8_t i = 0; i < 8; ++i)
+		{
+			pos.x = n->x + neighbourOrderList[i][0];
+			pos.y = n->y + neighbourOrderList[i][1];
+
+			bool outOfRange = false;
+			if(maxSearchDist != -1 && (std::abs(endPos.x - pos.x) > maxSearchDist ||
+				std::abs(endPos.y - pos.y) > maxSearchDist))
+				outOfRange = true;
+
+			if(!outOfRange && source.canWalk(pos, extraCost))
+			{
+				int32_t cost = nodes.getMapWalkCost(NULL, n, NULL, pos),
+					newg = n->g + cost + extraCost;
+
+				AStarNode* neighbourNode = nodes.getNodeInList(pos.x, pos.y);
+				if(neighbourNode)
+				{
+					if(neighbourNode->g <= newg)
+						continue;
+				}
+				else if(!(neighbourNode = nodes.createOpenNode()))
+				{
+					listDir.clear();
+					return false;
+				}
+
+				neighbourNode->x = pos.x;
+				neighbourNode->y = pos.y;
+
+				neighbourNode->g = newg;
+				neighbourNode->h = nodes.getEstimatedDistance(neighbourNode->x, neighbourNode->y, endPos.x, endPos.y);
+
+				neighbourNode->f = neighbourNode->g + neighbourNode->h;
+				neighbourNode->parent = n;
+				nodes.openNode(neighbourNode);
+			}
+		}
+
+		nodes.closeNode(n);
+	}
+
+	int32_t prevx = endPos.x, prevy = endPos.y, dx, dy;
+	while(found)
+	{
+		pos.x = found->x;
+		pos.y = found->y;
+
+		dx = pos.x - prevx;
+		dy = pos.y - prevy;
+
+		prevx = pos.x;
+		prevy = pos.y;
+
+		found = found->parent;
+		if(dx == -1 && dy == -1)
+			listDir.push_back(NORTHWEST);
+		else if(dx == 1 && dy == -1)
+			listDir.push_back(NORTHEAST);
+		else if(dx == -1 && dy == 1)
+			listDir.push_back(SOUTHWEST);
+		else if(dx == 1 && dy == 1)
+			listDir.push_back(SOUTHEAST);
+		else if(dx == -1)
+			listDir.push_back(WEST);
+		else if(dx == 1)
+			listDir.push_back(EAST);
+		else if(dy == -1)
+			listDir.push_back(NORTH);
+		else if(dy == 1)
+			listDir.push_back(SOUTH);
+	}
+
+	return !listDir.empty();
+}
+
+struct Query
+{
+	Position start, target;
+	FindPathParams fpp;
+	// getPathTo when set, getPathMatching otherwise
+	bool walkTo;
+};
+
+struct Result
+{
+	bool found;
+	std::list<Direction> dirList;
+};
+
+// walks towards a tile near the start, follows or keeps distance like monsters do
+static std::vector<Query> makeQueries(const std::vector<TilePosition>& tiles, uint32_t count)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<Query> queries(count);
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		Query& query = queries[i];
+		const TilePosition& start = tiles[rng() % tiles.size()];
+		query.start = Position(start.x, start.y, start.z);
+		query.target = Position(start.x + rng() % (QUERY_RADIUS * 2 + 1) - QUERY_RADIUS,
+			start.y + rng() % (QUERY_RADIUS * 2 + 1) - QUERY_RADIUS, start.z);
+
+		query.fpp.clearSight = false;
+		query.fpp.maxSearchDist = (i & 1) ? 12 : -1;
+		query.walkTo = false;
+		switch(rng() % 3)
+		{
+			case 0:
+				query.walkTo = true;
+				break;
+
+			case 1:
+				query.fpp.minTargetDist = 1;
+				query.fpp.maxTargetDist = 1;
+				break;
+
+			default:
+				query.fpp.fullPathSearch = (rng() & 1) != 0;
+				query.fpp.keepDistance = true;
+				query.fpp.minTargetDist = 1;
+				query.fpp.maxTargetDist = 4;
+				break;
+		}
+	}
+
+	return queries;
+}
+
+template<class Nodes>
+static void run(const char* name, const GridWalkSource& source, const std::vector<Query>& queries, std::vector<Result>& results)
+{
+	results.resize(queries.size());
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	uint32_t found = 0;
+	for(uint32_t i = 0; i < queries.size(); ++i)
+	{
+		const Query& query = queries[i];
+		Result& result = results[i];
+		if(query.walkTo)
+			result.found = getPathTo<Nodes>(source, query.start, query.target, result.dirList,
+				query.fpp.maxSearchDist, query.fpp.maxNodes);
+		else
+			result.found = findPathMatching<Nodes>(source, query.start, result.dirList,
+				TargetCondition(query.target), query.fpp);
+
+		if(result.found)
+			++found;
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cout << name << ": " << queries.size() << " queries " << us / 1000 << " ms, " << found << " paths, "
+		<< (us ? (uint64_t)queries.size() * 1000000 / us : 0) << " paths/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string file = argc > 1 ? argv[1] : "data/world/forgotten.otbm";
+	std::vector<TilePosition> positions, tiles;
+	if(!loadTilePositions(file, positions))
+	{
+		std::cout << "Could not read the tiles of " << file << std::endl;
+		return 1;
+	}
+
+	GridWalkSource source;
+	for(std::vector<TilePosition>::iterator it = positions.begin(); it != positions.end(); ++it)
+	{
+		if(it->z != FLOOR_Z)
+			continue;
+
+		source.add(it->x, it->y);
+		tiles.push_back(*it);
+	}
+
+	if(tiles.empty())
+	{
+		std::cout << "No tiles on floor " << (int32_t)FLOOR_Z << " of " << file << std::endl;
+		return 1;
+	}
+
+	std::cout << tiles.size() << " tiles on floor " << (int32_t)FLOOR_Z << " of " << file << std::endl;
+	std::vector<Query> queries = makeQueries(tiles, QUERIES);
+
+	std::vector<Result> legacy, heap;
+	run<LegacyAStarNodes>("scan", source, queries, legacy);
+	run<AStarNodes>("heap", source, queries, heap);
+	for(uint32_t i = 0; i < queries.size(); ++i)
+	{
+		if(legacy[i].found != heap[i].found || legacy[i].dirList != heap[i].dirList)
+		{
+			const Query& query = queries[i];
+			std::cout << "Query " << i << " from " << query.start.x << "/" << query.start.y << " to "
+				<< query.target.x << "/" << query.target.y
+				<< " found " << legacy[i].found << "/" << legacy[i].dirList.size() << " steps with the scan but "
+				<< heap[i].found << "/" << heap[i].dirList.size() << " with the heap" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
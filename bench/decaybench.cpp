@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+// Compares the DecayWheel with the 16 DecayList buckets it replaced on a
+// corpse-heavy item mix. Time is advanced by hand and decayed items are
+// rescheduled right away, so only the bookkeeping of Game::checkDecay is
+// measured. Before that, 30 days of irregular ticks check that the wheel
+// hands out every item on its due tick. Exits with 1 when an item comes out
+// early, late or not at all.
+
+#include "otpch.h"
+#include "decay.h"
+
+#include "tools.h"
+
+// the real clock lives in tools.cpp, the bench drives its own
+static int64_t benchTime = (int64_t)1700000000 * 1000;
+int64_t OTSYS_TIME() {return benchTime;}
+
+static const uint32_t TICK = 1000;
+static const uint32_t ITEMS = 200000;
+static const uint32_t TICKS = 3600;
+
+static const uint32_t CHECK_ITEMS = 10000;
+static const int64_t CHECK_TIME = (int64_t)30 * 24 * 60 * 60 * 1000;
+
+// the bucket decay ran every second over one of its 16 buckets
+static const uint32_t BUCKETS = 16;
+
+struct BenchItem
+{
+	int32_t duration;
+	int64_t expiry;
+	uint8_t kind, stage;
+};
+
+// the wheel only ever stores the pointer, it never reads an item
+static Item* toItem(BenchItem* item) {return (Item*)item;}
+static BenchItem* fromItem(Item* item) {return (BenchItem*)item;}
+
+// mostly corpses rotting in three stages, then fields and a few long lived items
+class CorpseMix
+{
+	public:
+		CorpseMix(): m_rng(0x5EED) {}
+
+		void spawn(BenchItem& item)
+		{
+			uint32_t roll = m_rng() % 100;
+			item.kind = (roll < 80 ? 0 : (roll < 95 ? 1 : 2));
+			item.stage = 0;
+			item.duration = getDuration(item);
+		}
+
+		// the next stage of a decayed item, or a new one in its place
+		void decayed(BenchItem& item)
+		{
+			if(item.kind || ++item.stage >= 3)
+			{
+				spawn(item);
+				return;
+			}
+
+			item.duration = getDuration(item);
+		}
+
+		// items of a running server are in every stage and halfway through it
+		void prefill(BenchItem& item)
+		{
+			spawn(item);
+			if(!item.kind)
+				item.stage = m_rng() % 3;
+
+			item.duration = 1 + m_rng() % getDuration(item);
+		}
+
+	protected:
+		int32_t getDuration(const BenchItem& item)
+		{
+			static const int32_t corpse[3] = {60000, 300000, 600000};
+			switch(item.kind)
+			{
+				case 0:
+					return corpse[item.stage];
+				case 1:
+					return 60000 + m_rng() % 120000;
+				default:
+					break;
+			}
+
+			return 3600000 + m_rng() % 82800000;
+		}
+
+		std::mt19937 m_rng;
+};
+
+// Game::checkDecay and Game::cleanup before the wheel
+class DecayBuckets
+{
+	public:
+		DecayBuckets(): m_lastBucket(0), m_touched(0), m_fired(0) {}
+
+		void start(BenchItem* item) {m_toDecayItems.push_back(item);}
+
+		void check(CorpseMix& mix)
+		{
+			size_t bucket = (m_lastBucket + 1) % BUCKETS;
+			for(std::list<BenchItem*>::iterator it = m_decayItems[bucket].begin(); it != m_decayItems[bucket].end();)
+			{
+				++m_touched;
+				BenchItem* item = *it;
+				int32_t decreaseTime = TICK * BUCKETS;
+				if(item->duration - decreaseTime < 0)
+					decreaseTime = item->duration;
+
+				item->duration -= decreaseTime;
+				int32_t dur = item->duration;
+				if(dur <= 0)
+				{
+					it = m_decayItems[bucket].erase(it);
+					decay(mix, item);
+				}
+				else if(dur < (int32_t)(TICK * BUCKETS))
+				{
+					it = m_decayItems[bucket].erase(it);
+					size_t newBucket = (bucket + ((dur + TICK / 2) / 1000)) % BUCKETS;
+					if(newBucket == bucket)
+						decay(mix, item);
+					else
+						m_decayItems[newBucket].push_back(item);
+				}
+				else
+					++it;
+			}
+
+			m_lastBucket = bucket;
+			cleanup();
+		}
+
+		void cleanup()
+		{
+			for(std::list<BenchItem*>::iterator it = m_toDecayItems.begin(); it != m_toDecayItems.end(); ++it)
+			{
+				int32_t dur = (*it)->duration;
+				if(dur >= (int32_t)(TICK * BUCKETS))
+					m_decayItems[m_lastBucket].push_back(*it);
+				else
+					m_decayItems[(m_lastBucket + 1 + dur / 1000) % BUCKETS].push_back(*it);
+			}
+
+			m_toDecayItems.clear();
+		}
+
+		uint64_t getTouched() const {return m_touched;}
+		uint64_t getFired() const {return m_fired;}
+
+		size_t size() const
+		{
+			size_t size = m_toDecayItems.size();
+			for(uint32_t i = 0; i < BUCKETS; ++i)
+				size += m_decayItems[i].size();
+
+			return size;
+		}
+
+	protected:
+		void decay(CorpseMix& mix, BenchItem* item)
+		{
+			//internalDecayItem, the new item starts decaying on its own
+			++m_fired;
+			mix.decayed(*item);
+			start(item);
+		}
+
+		std::list<BenchItem*> m_decayItems[BUCKETS];
+		std::list<BenchItem*> m_toDecayItems;
+		size_t m_lastBucket;
+		uint64_t m_touched, m_fired;
+};
+
+// the wheel side of Game::checkDecay, every entry has to come out on its due tick
+class WheelChecker
+{
+	public:
+		WheelChecker(): m_wheel(TICK), m_lastNow(benchTime), m_fired(0), m_failed(false)
+		{
+			DecayEntryList list;
+			m_wheel.advance(benchTime, list);
+		}
+
+		void start(BenchItem* item)
+		{
+			item->expiry = benchTime + item->duration;
+			m_wheel.add(toItem(item), item->expiry);
+		}
+
+		template<class Mix>
+		void check(Mix& mix)
+		{
+			int64_t now = benchTime;
+			DecayEntryList list;
+			m_wheel.advance(now, list);
+			for(DecayEntryList::iterator it = list.begin(); it != list.end(); ++it)
+			{
+				int64_t dueTick = (it->expiry + TICK - 1) / TICK;
+				if(it->expiry > now || dueTick <= m_lastNow / TICK)
+				{
+					if(!m_failed)
+						std::cout << "Item due at " << it->expiry << " came out at " << now << ", the tick before was at "
+							<< m_lastNow << std::endl;
+
+					m_failed = true;
+				}
+
+				++m_fired;
+				BenchItem* item = fromItem(it->item);
+				mix.decayed(*item);
+				start(item);
+			}
+
+			m_lastNow = now;
+		}
+
+		bool hasFailed() const {return m_failed;}
+		uint64_t getFired() const {return m_fired;}
+		DecayWheel& getWheel() {return m_wheel;}
+
+	protected:
+		DecayWheel m_wheel;
+		int64_t m_lastNow;
+		uint64_t m_fired;
+		bool m_failed;
+};
+
+// any duration up to the whole run, so every level of the wheel and its cascades are used
+class RandomMix
+{
+	public:
+		RandomMix(): m_rng(0xDECA) {}
+
+		void decayed(BenchItem& item)
+		{
+			int64_t range = (int64_t)1 << (m_rng() % 32);
+			item.duration = 1 + (int32_t)(m_rng() % std::min(range, CHECK_TIME));
+		}
+
+		uint32_t jitter() {return m_rng();}
+
+	protected:
+		std::mt19937 m_rng;
+};
+
+static bool checkWheel()
+{
+	RandomMix mix;
+	WheelChecker checker;
+	std::vector<BenchItem> items(CHECK_ITEMS);
+	for(std::vector<BenchItem>::iterator it = items.begin(); it != items.end(); ++it)
+	{
+		mix.decayed(*it);
+		checker.start(&*it);
+	}
+
+	//uneven ticks, and now and then a stall that covers several of them
+	int64_t end = benchTime + CHECK_TIME;
+	uint64_t advances = 0;
+	while(benchTime < end && !checker.hasFailed())
+	{
+		uint32_t roll = mix.jitter();
+		benchTime += (roll % 100 ? TICK - 200 + roll % 400 : TICK * (2 + roll % 8));
+		checker.check(mix);
+		++advances;
+	}
+
+	if(checker.hasFailed())
+		return false;
+
+	//nothing is lost, all items are still in the wheel for their next round
+	if(checker.getWheel().size() != CHECK_ITEMS)
+	{
+		std::cout << "The wheel holds " << checker.getWheel().size() << " items instead of " << CHECK_ITEMS << std::endl;
+		return false;
+	}
+
+	std::cout << "check: " << advances << " advances over 30 days, " << checker.getFired() << " items fired on their tick, "
+		<< checker.getWheel().getStats().cascaded << " cascaded" << std::endl;
+	return true;
+}
+
+int main()
+{
+	if(!checkWheel())
+		return 1;
+
+	int64_t start = benchTime;
+	std::vector<BenchItem> bucketItems(ITEMS);
+	CorpseMix bucketMix;
+	DecayBuckets buckets;
+	for(std::vector<BenchItem>::iterator it = bucketItems.begin(); it != bucketItems.end(); ++it)
+	{
+		bucketMix.prefill(*it);
+		buckets.start(&*it);
+	}
+
+	buckets.cleanup();
+	std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < TICKS; ++i)
+		buckets.check(bucketMix);
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	int64_t bucketUs = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+
+	std::vector<BenchItem> wheelItems(ITEMS);
+	CorpseMix wheelMix;
+	WheelChecker wheel;
+	for(std::vector<BenchItem>::iterator it = wheelItems.begin(); it != wheelItems.end(); ++it)
+	{
+		wheelMix.prefill(*it);
+		wheel.start(&*it);
+	}
+
+	begin = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < TICKS; ++i)
+	{
+		benchTime += TICK;
+		wheel.check(wheelMix);
+	}
+
+	end = std::chrono::high_resolution_clock::now();
+	int64_t wheelUs = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+	if(wheel.hasFailed())
+		return 1;
+
+	if(buckets.size() != ITEMS || wheel.getWheel().size() != ITEMS)
+	{
+		std::cout << "Lost items, " << buckets.size() << " in the buckets and " << wheel.getWheel().size()
+			<< " in the wheel out of " << ITEMS << std::endl;
+		return 1;
+	}
+
+	std::cout << "buckets: " << ITEMS << " items over " << TICKS << " ticks " << bucketUs / 1000 << " ms, "
+		<< (double)bucketUs / TICKS / 1000 << " ms/tick, " << buckets.getTouched() << " items touched, "
+		<< buckets.getFired() << " fired" << std::endl;
+	std::cout << "wheel: " << ITEMS << " items over " << (benchTime - start) / TICK << " ticks " << wheelUs / 1000 << " ms, "
+		<< (double)wheelUs / TICKS / 1000 << " ms/tick, " << wheel.getFired() << " fired, "
+		<< wheel.getWheel().getStats().cascaded << " cascaded" << std::endl;
+	return 0;
+}
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+// Compares the QTreeNode lookup with the flat MapGrid on the tile positions
+// of a real map (data/world/forgotten.otbm by default). Both layouts get the
+// same leaves and floors, every lookup has to agree before anything is timed.
+// Exits with 1 when the map cannot be read or the layouts differ.
+
+#include "otpch.h"
+#include "map.h"
+
+#include "otbmtiles.h"
+
+// the real constructor lives in map.cpp, which needs the whole game
+Floor::Floor()
+{
+	memset(tiles, 0, sizeof(tiles));
+	memset(bits, 0, sizeof(bits));
+}
+
+static const uint32_t LOOKUPS = 4000000;
+// windows like Creature::updateMapCache and the map description scan
+static const uint32_t WINDOWS = 20000;
+static const int32_t WINDOW_RADIUS = 11;
+
+// bench only ever compares the pointers, no tile is read
+static char tileMarker;
+static Tile* const TILE = (Tile*)&tileMarker;
+
+struct QTreeLayout
+{
+	static const char* getName() {return "qtree";}
+
+	QTreeLeafNode* createLeaf(uint16_t x, uint16_t y) {return root.createLeaf(x, y, 15);}
+	QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) {return QTreeNode::getLeafStatic(&root, x, y);}
+
+	QTreeNode root;
+};
+
+struct GridLayout
+{
+	static const char* getName() {return "grid";}
+
+	QTreeLeafNode* createLeaf(uint16_t x, uint16_t y) {return grid.createLeaf(x, y);}
+	QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) {return grid.getLeaf(x, y);}
+
+	MapGrid grid;
+};
+
+// same steps as Map::setTile and Map::getTile
+template<class Layout>
+static void setTile(Layout& layout, const TilePosition& pos)
+{
+	layout.createLeaf(pos.x, pos.y)->createFloor(pos.z)->tiles[pos.x & FLOOR_MASK][pos.y & FLOOR_MASK] = TILE;
+}
+
+template<class Layout>
+static Tile* getTile(Layout& layout, int32_t x, int32_t y, int32_t z)
+{
+	if(x < 0 || x > 0xFFFF || y < 0 || y > 0xFFFF || z < 0 || z >= MAP_MAX_LAYERS)
+		return NULL;
+
+	QTreeLeafNode* leaf = layout.getLeaf(x, y);
+	if(!leaf)
+		return NULL;
+
+	Floor* floor = leaf->getFloor(z);
+	if(!floor)
+		return NULL;
+
+	return floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK];
+}
+
+// random lookups around real tiles, some of them miss
+static std::vector<TilePosition> makeLookups(const std::vector<TilePosition>& positions, uint32_t count)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<TilePosition> lookups(count);
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		lookups[i] = positions[rng() % positions.size()];
+		lookups[i].x += rng() % 17 - 8;
+		lookups[i].y += rng() % 17 - 8;
+	}
+
+	return lookups;
+}
+
+template<class Layout>
+static uint64_t checksum(Layout& layout, const std::vector<TilePosition>& lookups)
+{
+	//hit pattern of the lookups, equal for both layouts when they agree
+	uint64_t sum = 0;
+	for(uint32_t i = 0; i < lookups.size(); ++i)
+	{
+		if(getTile(layout, lookups[i].x, lookups[i].y, lookups[i].z))
+			sum += (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+	}
+
+	return sum;
+}
+
+template<class Layout>
+static void run(Layout& layout, const std::vector<TilePosition>& lookups, const std::vector<TilePosition>& windows)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	uint32_t hits = 0;
+	for(std::vector<TilePosition>::const_iterator it = lookups.begin(); it != lookups.end(); ++it)
+	{
+		if(getTile(layout, it->x, it->y, it->z))
+			++hits;
+	}
+
+	std::chrono::high_resolution_clock::time_point looked = std::chrono::high_resolution_clock::now();
+	uint32_t windowHits = 0;
+	for(std::vector<TilePosition>::const_iterator it = windows.begin(); it != windows.end(); ++it)
+	{
+		for(int32_t y = it->y - WINDOW_RADIUS; y <= it->y + WINDOW_RADIUS; ++y)
+		{
+			for(int32_t x = it->x - WINDOW_RADIUS; x <= it->x + WINDOW_RADIUS; ++x)
+			{
+				if(getTile(layout, x, y, it->z))
+					++windowHits;
+			}
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	std::cout << Layout::getName() << ": " << lookups.size() << " getTile "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(looked - start).count() << " ms (" << hits << " hits), "
+		<< windows.size() << " windows " << std::chrono::duration_cast<std::chrono::milliseconds>(end - looked).count()
+		<< " ms (" << windowHits << " hits)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string file = argc > 1 ? argv[1] : "data/world/forgotten.otbm";
+	std::vector<TilePosition> positions;
+	if(!loadTilePositions(file, positions))
+	{
+		std::cout << "Could not read the tiles of " << file << std::endl;
+		return 1;
+	}
+
+	QTreeLayout qtree;
+	GridLayout grid;
+	for(std::vector<TilePosition>::iterator it = positions.begin(); it != positions.end(); ++it)
+	{
+		setTile(qtree, *it);
+		setTile(grid, *it);
+	}
+
+	std::cout << positions.size() << " tiles from " << file << std::endl;
+	std::vector<TilePosition> lookups = makeLookups(positions, LOOKUPS), windows = makeLookups(positions, WINDOWS);
+	for(std::vector<TilePosition>::iterator it = positions.begin(); it != positions.end(); ++it)
+	{
+		if(getTile(qtree, it->x, it->y, it->z) != TILE || getTile(grid, it->x, it->y, it->z) != TILE)
+		{
+			std::cout << "Tile " << it->x << "/" << it->y << "/" << (int32_t)it->z << " is missing" << std::endl;
+			return 1;
+		}
+	}
+
+	if(checksum(qtree, lookups) != checksum(grid, lookups))
+	{
+		std::cout << "The layouts disagree on empty positions" << std::endl;
+		return 1;
+	}
+
+	run(qtree, lookups, windows);
+	run(grid, lookups, windows);
+	return 0;
+}
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+// Checks every XTEA and Adler-32 kernel this CPU can run against the scalar
+// one on random, unaligned buffers of random length, then measures each on
+// protocol sized packets. Exits with 1 when any kernel differs from scalar.
+
+#include "otpch.h"
+#include "netcrypto.h"
+
+static const char* const KERNELS[] = {"scalar", "SSE2", "AVX2"};
+static const uint32_t CHECKS = 2000;
+// larger than a packet so the vector Adler-32 has to reduce several times
+static const size_t MAX_LENGTH = 3 * 4096 + 100;
+static const size_t PACKET_SIZE = 8192;
+static const size_t BENCH_BYTES = 256 << 20;
+
+struct Sample
+{
+	std::vector<uint8_t> data;
+	size_t offset, length;
+	uint32_t key[4];
+};
+
+static std::vector<Sample> makeSamples()
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<Sample> samples(CHECKS);
+	for(uint32_t i = 0; i < CHECKS; ++i)
+	{
+		Sample& sample = samples[i];
+		// the first lengths cover every vector remainder, the rest are random
+		sample.length = i < 256 ? i : rng() % MAX_LENGTH;
+		sample.offset = rng() % 8;
+		sample.data.resize(sample.offset + sample.length);
+		for(size_t j = 0; j < sample.data.size(); ++j)
+			sample.data[j] = rng();
+
+		for(int32_t j = 0; j < 4; ++j)
+			sample.key[j] = rng();
+	}
+
+	return samples;
+}
+
+// output of the current kernels for every sample: encrypted, decrypted and checksum
+static std::vector<std::vector<uint8_t> > runSamples(const std::vector<Sample>& samples)
+{
+	std::vector<std::vector<uint8_t> > results;
+	for(std::vector<Sample>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+	{
+		std::vector<uint8_t> buffer(it->data);
+		uint8_t* data = &buffer[0] + it->offset;
+		size_t blocks = it->length / 8;
+
+		uint32_t checksum = adler32(data, it->length);
+		xteaEncrypt((uint32_t*)data, blocks, it->key);
+		std::vector<uint8_t> result(data, data + it->length);
+		xteaDecrypt((uint32_t*)data, blocks, it->key);
+		result.insert(result.end(), data, data + it->length);
+
+		result.insert(result.end(), (uint8_t*)&checksum, (uint8_t*)&checksum + sizeof(checksum));
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+static double megabytesPerSecond(std::chrono::high_resolution_clock::time_point start)
+{
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return BENCH_BYTES / seconds / (1 << 20);
+}
+
+static void bench()
+{
+	// one byte in so the loads are unaligned like in the output messages
+	std::vector<uint8_t> buffer(PACKET_SIZE + 1, 0xA5);
+	uint8_t* data = &buffer[1];
+	const uint32_t key[4] = {0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210};
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for(size_t done = 0; done < BENCH_BYTES; done += PACKET_SIZE)
+		xteaEncrypt((uint32_t*)data, PACKET_SIZE / 8, key);
+
+	double encrypt = megabytesPerSecond(start);
+	start = std::chrono::high_resolution_clock::now();
+	for(size_t done = 0; done < BENCH_BYTES; done += PACKET_SIZE)
+		xteaDecrypt((uint32_t*)data, PACKET_SIZE / 8, key);
+
+	double decrypt = megabytesPerSecond(start);
+	volatile uint32_t checksum = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for(size_t done = 0; done < BENCH_BYTES; done += PACKET_SIZE)
+		checksum = checksum + adler32(data, PACKET_SIZE);
+
+	double adler = megabytesPerSecond(start);
+	std::cout << getNetCryptoKernel() << ": xtea encrypt " << (uint32_t)encrypt << " MB/s, decrypt "
+		<< (uint32_t)decrypt << " MB/s, adler32 " << (uint32_t)adler << " MB/s" << std::endl;
+}
+
+int main()
+{
+	std::vector<Sample> samples = makeSamples();
+	setNetCryptoKernel("scalar");
+	std::vector<std::vector<uint8_t> > expected = runSamples(samples);
+
+	bool failed = false;
+	for(size_t i = 0; i < sizeof(KERNELS) / sizeof(KERNELS[0]); ++i)
+	{
+		if(!setNetCryptoKernel(KERNELS[i]))
+		{
+			std::cout << KERNELS[i] << ": not supported, skipped" << std::endl;
+			continue;
+		}
+
+		std::vector<std::vector<uint8_t> > results = runSamples(samples);
+		for(uint32_t j = 0; j < CHECKS; ++j)
+		{
+			if(results[j] == expected[j])
+				continue;
+
+			std::cout << KERNELS[i] << ": differs from scalar at " << samples[j].length
+				<< " bytes, offset " << samples[j].offset << std::endl;
+			failed = true;
+			break;
+		}
+
+		bench();
+	}
+
+	return failed ? 1 : 0;
+}
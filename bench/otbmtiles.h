@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __OTBMTILES__
+#define __OTBMTILES__
+
+#include "iomap.h"
+#include "fileloader.h"
+
+// Tile positions of an .otbm map for the benchmarks, read with the same nodes
+// IOMap::loadMap walks but without items.otb, so nothing but the positions.
+
+struct TilePosition
+{
+	uint16_t x, y;
+	uint8_t z;
+};
+
+static bool loadTilePositions(const std::string& file, std::vector<TilePosition>& positions)
+{
+	FileLoader f;
+	if(!f.openFile(file.c_str(), false, true))
+		return false;
+
+	uint32_t type = 0;
+	NODE root = f.getChildNode((NODE)NULL, type);
+	NODE nodeMap = f.getChildNode(root, type);
+	if(type != OTBM_MAP_DATA)
+		return false;
+
+	PropStream propStream;
+	for(NODE nodeArea = f.getChildNode(nodeMap, type); nodeArea != NO_NODE; nodeArea = f.getNextNode(nodeArea, type))
+	{
+		if(type != OTBM_TILE_AREA)
+			continue;
+
+		OTBM_Destination_coords* areaCoord;
+		if(!f.getProps(nodeArea, propStream) || !propStream.getStruct(areaCoord))
+			return false;
+
+		TilePosition pos;
+		pos.z = areaCoord->_z;
+		uint16_t baseX = areaCoord->_x, baseY = areaCoord->_y;
+		for(NODE nodeTile = f.getChildNode(nodeArea, type); nodeTile != NO_NODE; nodeTile = f.getNextNode(nodeTile, type))
+		{
+			if(type != OTBM_TILE && type != OTBM_HOUSETILE)
+				continue;
+
+			OTBM_Tile_coords* tileCoord;
+			if(!f.getProps(nodeTile, propStream) || !propStream.getStruct(tileCoord))
+				return false;
+
+			pos.x = baseX + tileCoord->_x;
+			pos.y = baseY + tileCoord->_y;
+			positions.push_back(pos);
+		}
+	}
+
+	return f.getError() == ERROR_NONE && !positions.empty();
+}
+#endif
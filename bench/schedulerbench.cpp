@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+// Compares the timing wheel Scheduler with the priority queue and event id
+// set it replaced, on 500k pending events. Neither side runs a thread, time
+// is advanced by hand so only the bookkeeping is measured.
+
+#include "otpch.h"
+#include "scheduler.h"
+
+// the real pool and dispatcher live in dispatcher.cpp, which needs the whole game
+Dispatcher g_dispatcher;
+void Dispatcher::addTask(Task* task, bool) {delete task;}
+void* TaskPool::allocate(size_t size) {return ::operator new(size);}
+void TaskPool::deallocate(void* block, size_t) {::operator delete(block);}
+
+static const uint32_t EVENTS = 500000;
+// delays of up to ten minutes, like walks, conditions, spawns and lua events
+static const uint32_t MAX_DELAY = 10 * 60 * 1000;
+
+static uint32_t executed = 0;
+static void execute() {++executed;}
+
+struct lessTask
+{
+	bool operator()(const SchedulerTask* lhs, const SchedulerTask* rhs) const {
+		return lhs->getCycle() > rhs->getCycle();
+	}
+};
+
+// the scheduler before the timing wheel
+class HeapScheduler
+{
+	public:
+		uint32_t addEvent(SchedulerTask* task)
+		{
+			task->setEventId(++m_lastEvent);
+			m_eventIds.insert(task->getEventId());
+			m_eventList.push(task);
+			return task->getEventId();
+		}
+
+		bool stopEvent(uint32_t eventId) {return m_eventIds.erase(eventId) != 0;}
+
+		void drain()
+		{
+			while(!m_eventList.empty())
+			{
+				SchedulerTask* task = m_eventList.top();
+				m_eventList.pop();
+				if(m_eventIds.erase(task->getEventId()))
+					(*task)();
+
+				delete task;
+			}
+		}
+
+	protected:
+		uint32_t m_lastEvent = 0;
+		std::priority_queue<SchedulerTask*, std::vector<SchedulerTask*>, lessTask> m_eventList;
+		std::set<uint32_t> m_eventIds;
+};
+
+// the timing wheel driven without its thread
+class WheelScheduler : public Scheduler
+{
+	public:
+		WheelScheduler() {setState(STATE_RUNNING);}
+
+		void drain()
+		{
+			advance(getTick(std::chrono::system_clock::now() + std::chrono::milliseconds(MAX_DELAY)) + 1);
+			for(std::deque<SchedulerTask*>::iterator it = m_readyList.begin(); it != m_readyList.end(); ++it)
+			{
+				if(m_eventIds.erase((*it)->getEventId()))
+					(**it)();
+
+				delete *it;
+			}
+
+			m_readyList.clear();
+		}
+};
+
+template<typename T>
+static void run(const char* name, const std::vector<uint32_t>& delays)
+{
+	typedef std::chrono::steady_clock Clock;
+	T scheduler;
+	std::vector<uint32_t> ids(EVENTS);
+	executed = 0;
+
+	Clock::time_point start = Clock::now();
+	for(uint32_t i = 0; i < EVENTS; ++i)
+		ids[i] = scheduler.addEvent(createSchedulerTaskWithOrigin("bench", delays[i], &execute));
+
+	Clock::time_point added = Clock::now();
+	// every other event is rescheduled, as a walk or an attack is
+	for(uint32_t i = 0; i < EVENTS; i += 2)
+	{
+		scheduler.stopEvent(ids[i]);
+		ids[i] = scheduler.addEvent(createSchedulerTaskWithOrigin("bench", delays[EVENTS - 1 - i], &execute));
+	}
+
+	Clock::time_point rescheduled = Clock::now();
+	scheduler.drain();
+
+	Clock::time_point drained = Clock::now();
+	std::cout << name << ": add " << std::chrono::duration_cast<std::chrono::milliseconds>(added - start).count()
+		<< " ms, stop and add again " << std::chrono::duration_cast<std::chrono::milliseconds>(rescheduled - added).count()
+		<< " ms, run all " << std::chrono::duration_cast<std::chrono::milliseconds>(drained - rescheduled).count()
+		<< " ms, " << executed << " executed" << std::endl;
+}
+
+int main()
+{
+	std::mt19937 generator(0);
+	std::uniform_int_distribution<uint32_t> distribution(SCHEDULER_MINTICKS, MAX_DELAY);
+
+	std::vector<uint32_t> delays(EVENTS);
+	for(uint32_t i = 0; i < EVENTS; ++i)
+		delays[i] = distribution(generator);
+
+	std::cout << EVENTS << " pending events" << std::endl;
+	run<HeapScheduler>("priority queue", delays);
+	run<WheelScheduler>("timing wheel", delays);
+	return 0;
+}
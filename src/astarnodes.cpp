@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "map.h"
+
+thread_local AStarArena AStarNodes::m_threadArena;
+
+void AStarArena::prepare(uint32_t maxNodes)
+{
+	if(nodes.size() < maxNodes)
+	{
+		nodes.resize(maxNodes);
+		heapIndex.resize(maxNodes);
+	}
+
+	uint32_t bits = 1;
+	while((1U << bits) < maxNodes * 2)
+		++bits;
+
+	if(table.size() < (1U << bits))
+	{
+		Slot empty = {0, 0, 0};
+		table.assign(1U << bits, empty);
+		tableShift = 32 - bits;
+		stamp = 0;
+	}
+
+	heap.clear();
+	if(!++stamp)
+	{
+		//wrapped around, forget every slot for real
+		for(std::vector<Slot>::iterator it = table.begin(); it != table.end(); ++it)
+			it->stamp = 0;
+
+		stamp = 1;
+	}
+}
+
+AStarNodes::AStarNodes(uint32_t maxNodes/* = MAX_NODES*/)
+{
+	//a nested search on the same thread gets its own storage
+	m_arena = (m_threadArena.inUse ? &m_localArena : &m_threadArena);
+	m_arena->inUse = true;
+	m_arena->prepare(std::max((uint32_t)1, maxNodes));
+
+	m_count = 0;
+	m_maxNodes = maxNodes;
+}
+
+AStarNodes::~AStarNodes()
+{
+	m_arena->inUse = false;
+}
+
+AStarNode* AStarNodes::createOpenNode()
+{
+	if(m_count >= m_maxNodes)
+		return NULL;
+
+	uint32_t index = m_count++;
+	m_arena->heapIndex[index] = -2; //not opened yet, so not in the table either
+	return &m_arena->nodes[index];
+}
+
+AStarNode* AStarNodes::getBestNode()
+{
+	if(m_arena->heap.empty())
+		return NULL;
+
+	//the linear scan this replaces ignored nodes from 100000 on
+	AStarNode* node = &m_arena->nodes[m_arena->heap.front()];
+	if(node->f >= 100000)
+		return NULL;
+
+	return node;
+}
+
+void AStarNodes::closeNode(AStarNode* node)
+{
+	uint32_t index = getIndex(node);
+	if(index >= m_count)
+	{
+		std::clog << "AStarNodes. trying to close node out of range" << std::endl;
+		return;
+	}
+
+	int32_t pos = m_arena->heapIndex[index];
+	if(pos < 0)
+		return;
+
+	std::vector<uint32_t>& heap = m_arena->heap;
+	m_arena->heapIndex[index] = -1;
+
+	uint32_t last = heap.back();
+	heap.pop_back();
+	if((uint32_t)pos == heap.size())
+		return;
+
+	setHeap(pos, last);
+	siftUp(pos);
+	siftDown(m_arena->heapIndex[last]);
+}
+
+void AStarNodes::openNode(AStarNode* node)
+{
+	uint32_t index = getIndex(node);
+	if(index >= m_count)
+	{
+		std::clog << "AStarNodes. trying to open node out of range" << std::endl;
+		return;
+	}
+
+	int32_t pos = m_arena->heapIndex[index];
+	if(pos == -2)
+	{
+		uint32_t key = ((uint32_t)node->x << 16) | node->y, slot = (key * 0x9E3779B1U) >> m_arena->tableShift,
+			mask = m_arena->table.size() - 1;
+		while(m_arena->table[slot].stamp == m_arena->stamp)
+			slot = (slot + 1) & mask;
+
+		AStarArena::Slot& entry = m_arena->table[slot];
+		entry.key = key;
+		entry.node = index;
+		entry.stamp = m_arena->stamp;
+	}
+
+	if(pos < 0)
+	{
+		m_arena->heap.push_back(index);
+		pos = m_arena->heap.size() - 1;
+		m_arena->heapIndex[index] = pos;
+	}
+
+	//the cost of an open node may have gone either way
+	siftUp(pos);
+	siftDown(m_arena->heapIndex[index]);
+}
+
+AStarNode* AStarNodes::getNodeInList(uint16_t x, uint16_t y)
+{
+	uint32_t key = ((uint32_t)x << 16) | y, slot = (key * 0x9E3779B1U) >> m_arena->tableShift,
+		mask = m_arena->table.size() - 1;
+	while(m_arena->table[slot].stamp == m_arena->stamp)
+	{
+		if(m_arena->table[slot].key == key)
+			return &m_arena->nodes[m_arena->table[slot].node];
+
+		slot = (slot + 1) & mask;
+	}
+
+	return NULL;
+}
+
+bool AStarNodes::isBetter(uint32_t a, uint32_t b) const
+{
+	//ties go to the older node, just like the linear scan did
+	int32_t fa = m_arena->nodes[a].f, fb = m_arena->nodes[b].f;
+	return fa < fb || (fa == fb && a < b);
+}
+
+void AStarNodes::setHeap(uint32_t pos, uint32_t node)
+{
+	m_arena->heap[pos] = node;
+	m_arena->heapIndex[node] = pos;
+}
+
+void AStarNodes::siftUp(uint32_t pos)
+{
+	std::vector<uint32_t>& heap = m_arena->heap;
+	uint32_t node = heap[pos];
+	while(pos)
+	{
+		uint32_t parent = (pos - 1) / 2;
+		if(!isBetter(node, heap[parent]))
+			break;
+
+		setHeap(pos, heap[parent]);
+		pos = parent;
+	}
+
+	setHeap(pos, node);
+}
+
+void AStarNodes::siftDown(uint32_t pos)
+{
+	std::vector<uint32_t>& heap = m_arena->heap;
+	uint32_t node = heap[pos], size = heap.size();
+	while(true)
+	{
+		uint32_t child = pos * 2 + 1;
+		if(child >= size)
+			break;
+
+		if(child + 1 < size && isBetter(heap[child + 1], heap[child]))
+			++child;
+
+		if(!isBetter(heap[child], node))
+			break;
+
+		setHeap(pos, heap[child]);
+		pos = child;
+	}
+
+	setHeap(pos, node);
+}
+
+int32_t AStarNodes::getMapWalkCost(const Creature*, AStarNode* node,
+	const Tile*, const Position& neighbourPos)
+{
+	if(std::abs(node->x - neighbourPos.x) == std::abs(node->y - neighbourPos.y)) //diagonal movement extra cost
+		return MAP_DIAGONALWALKCOST;
+
+	return MAP_NORMALWALKCOST;
+}
+
+int32_t AStarNodes::getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal)
+{
+	int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
+	return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(
+		x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
+}
@@ -327,6 +327,16 @@ bool ConfigManager::load()
 	m_confNumber[EXHAUST_ONSELL] = getGlobalNumber("onSell", 500);
 	m_confNumber[EXHAUST_CHANGEOUFIT] = getGlobalNumber("changeOutfit", 500);
 	m_confBool[CLIENT_PING] = getGlobalBool("clientPing", false);	
+	m_confBool[DISPATCHER_PROFILER] = getGlobalBool("dispatcherProfiler", true);
+	m_confNumber[DISPATCHER_PROFILER_INTERVAL] = getGlobalNumber("dispatcherProfilerInterval", 5 * 60);
+	m_confNumber[PATHFINDING_THREADS] = getGlobalNumber("pathfindingThreads", 0);
+	m_confBool[PATHFINDING_FLOW_FIELDS] = getGlobalBool("pathfindingFlowFields", false);
+	m_confNumber[REGION_ACTIVATION_RADIUS] = getGlobalNumber("regionActivationRadius", 16);
+	m_confNumber[CLEAN_MAP_SLICE] = getGlobalNumber("cleanMapSlice", 250);
+	m_confNumber[NETWORK_THREADS] = getGlobalNumber("networkThreads", 1);
+	m_confNumber[RSA_THREADS] = getGlobalNumber("rsaThreads", 2);
+	m_confNumber[RSA_QUEUE_SIZE] = getGlobalNumber("rsaQueueSize", 256);
+	m_confNumber[CAST_VIEWER_STALL] = getGlobalNumber("castViewerStall", 5000);
 
 	m_loaded = true;
 	return true;
@@ -180,6 +180,14 @@ class ConfigManager
 			EXHAUST_ONBUY,
 			EXHAUST_ONSELL,
 			EXHAUST_CHANGEOUFIT,
+			DISPATCHER_PROFILER_INTERVAL,
+			PATHFINDING_THREADS,
+			REGION_ACTIVATION_RADIUS,
+			CLEAN_MAP_SLICE,
+			NETWORK_THREADS,
+			RSA_THREADS,
+			RSA_QUEUE_SIZE,
+			CAST_VIEWER_STALL,
 			LAST_NUMBER_CONFIG /* this must be the last one */
 		};
 
@@ -298,6 +306,8 @@ class ConfigManager
 			ENABLE_CAST, //CAST
 			COMPRESS_PACKET,
 			CLIENT_PING,
+			DISPATCHER_PROFILER,
+			PATHFINDING_FLOW_FIELDS,
 			LAST_BOOL_CONFIG /* this must be the last one */
 		};
 
@@ -31,12 +31,14 @@
 #include "server.h"
 #include "configmanager.h"
 
+#include "cryptopool.h"
 #include "textlogger.h"
 #include "tools.h"
 
 extern ConfigManager g_config;
 
 bool Connection::m_logError = true;
+ConnectionStats Connection::m_stats;
 
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
 uint32_t Connection::connectionCount = 0;
@@ -100,7 +102,7 @@ void Connection::close()
 		return;
 
 	m_connectionState = CONNECTION_STATE_REQUEST_CLOSE;
-	g_dispatcher.addTask(createTask(std::bind(&Connection::closeConnection, this)));
+	g_dispatcher.addTask(createTaskWithOrigin("Connection::close", std::bind(&Connection::closeConnection, this)));
 }
 
 bool ConnectionManager::isDisabled(uint32_t clientIp, int32_t protocolId)
@@ -223,6 +225,8 @@ void Connection::closeSocket()
 	std::clog << "Connection::closeSocket" << std::endl;
 	#endif
 	m_connectionLock.lock();
+	//queued messages hold the connection, they must not outlive the socket
+	m_writeQueue.clear();
 	if(m_socket->is_open())
 	{
 		#ifdef __DEBUG_NET_DETAIL__
@@ -263,7 +267,7 @@ void Connection::closeSocket()
 void Connection::releaseConnection()
 {
 	if(m_refCount > 0) { //Reschedule it and try again.
-		g_dispatcher.addTask(createTask(std::bind(&Connection::releaseConnection, this)));
+		g_dispatcher.addTask(createTaskWithOrigin("Connection::releaseConnection", std::bind(&Connection::releaseConnection, this)));
 	}
 	else 
 	{
@@ -301,7 +305,7 @@ void Connection::deleteConnection()
 	assert(!m_refCount);
 	try
 	{
-		m_service.dispatch(std::bind(&Connection::onStop, this));
+		m_strand.dispatch(std::bind(&Connection::onStop, this));
 	}
 	catch(std::exception& e)
 	{
@@ -326,13 +330,13 @@ void Connection::accept()
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_READ_TIMEOUT));
-		m_readTimer.async_wait(std::bind(&Connection::handleReadTimeout,
-			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1));
+		m_readTimer.async_wait(m_strand.wrap(std::bind(&Connection::handleReadTimeout,
+			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1)));
 
 		// Read size of the first packet
 		boost::asio::async_read(getHandle(),
 			boost::asio::buffer(m_msg.buffer(), NETWORK_HEADER_SIZE),
-			std::bind(&Connection::parseHeader, shared_from_this(), std::placeholders::_1));
+			m_strand.wrap(std::bind(&Connection::parseHeader, shared_from_this(), std::placeholders::_1)));
 	}
 	catch(std::exception& e)
 	{
@@ -379,13 +383,13 @@ void Connection::parseHeader(const boost::system::error_code& error)
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_READ_TIMEOUT));
-		m_readTimer.async_wait(std::bind(&Connection::handleReadTimeout,
-			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1));
+		m_readTimer.async_wait(m_strand.wrap(std::bind(&Connection::handleReadTimeout,
+			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1)));
 
 		// Read packet content
 		m_msg.setSize(size + NETWORK_HEADER_SIZE);
 		boost::asio::async_read(getHandle(), boost::asio::buffer(m_msg.bodyBuffer(), size),
-			std::bind(&Connection::parsePacket, shared_from_this(), std::placeholders::_1));
+			m_strand.wrap(std::bind(&Connection::parsePacket, shared_from_this(), std::placeholders::_1)));
 	}
 	catch(std::exception& e)
 	{
@@ -446,6 +450,16 @@ void Connection::parsePacket(const boost::system::error_code& error)
 		else
 			m_msg.skip(1); // Skip protocol
 
+		if(m_protocol->hasEncryptedFirstMessage() && g_cryptoPool.isRunning())
+		{
+			// the next read is started by handleFirstMessage
+			if(!g_cryptoPool.addJob(shared_from_this(), m_msg))
+				close();
+
+			m_connectionLock.unlock();
+			return;
+		}
+
 		m_protocol->onRecvFirstMessage(m_msg);
 	}
 	else
@@ -455,13 +469,13 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_READ_TIMEOUT));
-		m_readTimer.async_wait(std::bind(&Connection::handleReadTimeout,
-			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1));
+		m_readTimer.async_wait(m_strand.wrap(std::bind(&Connection::handleReadTimeout,
+			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1)));
 
 		// Wait to the next packet
 		boost::asio::async_read(getHandle(),
 			boost::asio::buffer(m_msg.buffer(), NETWORK_HEADER_SIZE),
-			std::bind(&Connection::parseHeader, shared_from_this(), std::placeholders::_1));
+			m_strand.wrap(std::bind(&Connection::parseHeader, shared_from_this(), std::placeholders::_1)));
 	}
 	catch(std::exception& e)
 	{
@@ -476,7 +490,7 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	m_connectionLock.unlock();
 }
 
-bool Connection::send(OutputMessage_ptr msg)
+bool Connection::send(OutputMessage_ptr msg, bool corked/* = false*/)
 {
 	#ifdef __DEBUG_NET_DETAIL__
 	std::clog << "Connection::send init" << std::endl;
@@ -497,7 +511,9 @@ bool Connection::send(OutputMessage_ptr msg)
 		#ifdef __DEBUG_NET_DETAIL__
 		std::clog << "Connection::send " << msg->size() << std::endl;
 		#endif
-		internalSend(msg);
+		m_writeQueue.push_back(msg);
+		if(!corked)
+			internalSend();
 	}
 	else if(m_pendingWrite > 100 && g_config.getBool(ConfigManager::FORCE_CLOSE_SLOW_CONNECTION))
 	{
@@ -505,7 +521,8 @@ bool Connection::send(OutputMessage_ptr msg)
 		close();
 	}
 	else
-	{	
+	{
+		//not encrypted yet, so the protocol keeps appending to it until the write is done
 		#ifdef __DEBUG_NET__
 		std::clog << "Connection::send Adding to queue " << msg->size() << std::endl;
 		#endif
@@ -516,19 +533,42 @@ bool Connection::send(OutputMessage_ptr msg)
 	return true;
 }
 
-void Connection::internalSend(OutputMessage_ptr msg)
+void Connection::flush()
 {
-	TRACK_MESSAGE(msg);
+	std::lock_guard<std::recursive_mutex> lockClass(m_connectionLock);
+	if(!m_pendingWrite && !m_writeQueue.empty() && m_connectionState == CONNECTION_STATE_OPEN && !m_writeError)
+		internalSend();
+}
+
+int64_t Connection::getWriteStall() const
+{
+	int64_t start = m_writeStart;
+	return start ? OTSYS_TIME() - start : 0;
+}
+
+void Connection::internalSend()
+{
+	//everything queued goes out as one gathered write, sends during it are re-queued in the pool
+	m_writeBatch.swap(m_writeQueue);
+	m_writeBuffers.clear();
+	for(std::vector<OutputMessage_ptr>::iterator it = m_writeBatch.begin(); it != m_writeBatch.end(); ++it)
+	{
+		TRACK_MESSAGE(*it);
+		m_writeBuffers.push_back(boost::asio::buffer((*it)->getOutputBuffer(), (*it)->size()));
+	}
+
+	m_stats.messages += m_writeBatch.size();
+	++m_stats.writes;
 	try
 	{
 		++m_pendingWrite;
+		m_writeStart = OTSYS_TIME();
 		m_writeTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_WRITE_TIMEOUT));
-		m_writeTimer.async_wait(std::bind(&Connection::handleWriteTimeout,
-			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1));
+		m_writeTimer.async_wait(m_strand.wrap(std::bind(&Connection::handleWriteTimeout,
+			std::weak_ptr<Connection>(shared_from_this()), std::placeholders::_1)));
 
-		boost::asio::async_write(getHandle(),
-			boost::asio::buffer(msg->getOutputBuffer(), msg->size()),
-			std::bind(&Connection::onWrite, shared_from_this(), msg, std::placeholders::_1));
+		boost::asio::async_write(getHandle(), m_writeBuffers,
+			m_strand.wrap(std::bind(&Connection::onWrite, shared_from_this(), std::placeholders::_1)));
 	}
 	catch(std::exception& e)
 	{
@@ -540,6 +580,16 @@ void Connection::internalSend(OutputMessage_ptr msg)
 	}
 }
 
+void Connection::handleFirstMessage(NetworkMessage& msg)
+{
+	std::lock_guard<std::recursive_mutex> lockClass(m_connectionLock);
+	if(m_connectionState != CONNECTION_STATE_OPEN || m_readError || !m_protocol)
+		return;
+
+	m_protocol->onRecvFirstMessage(msg);
+	accept();
+}
+
 uint32_t Connection::getIP() const
 {
 	//ip is expressed in network byte order
@@ -552,7 +602,7 @@ uint32_t Connection::getIP() const
 	return 0;
 }
 
-void Connection::onWrite(OutputMessage_ptr msg, const boost::system::error_code& error)
+void Connection::onWrite(const boost::system::error_code& error)
 {
 	#ifdef __DEBUG_NET_DETAIL__
 	std::clog << "onWrite" << std::endl;
@@ -560,8 +610,9 @@ void Connection::onWrite(OutputMessage_ptr msg, const boost::system::error_code&
 	m_connectionLock.lock();
 	m_writeTimer.cancel();
 
-	TRACK_MESSAGE(msg);
-	msg.reset();
+	m_writeBuffers.clear();
+	m_writeBatch.clear();
+	m_writeStart = 0;
 	if(error)
 		handleWriteError(error);
 
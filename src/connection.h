@@ -53,6 +53,12 @@ struct ConnectBlock
 	uint64_t startTime, blockTime;
 };
 
+struct ConnectionStats
+{
+	// writes counts the async_write calls, each carrying all the messages queued on its connection
+	std::atomic<uint64_t> writes{0}, messages{0};
+};
+
 class Protocol;
 class ConnectionManager
 {
@@ -107,12 +113,14 @@ class Connection : public std::enable_shared_from_this<Connection>
 #endif
 	private:
 		Connection(boost::asio::ip::tcp::socket* socket, boost::asio::io_service& io_service, ServicePort_ptr servicePort):
-			m_socket(socket), m_readTimer(io_service), m_writeTimer(io_service), m_service(io_service), m_servicePort(servicePort)
+			m_socket(socket), m_readTimer(io_service), m_writeTimer(io_service), m_service(io_service), m_strand(io_service),
+			m_servicePort(servicePort)
 		{
 			m_refCount = m_pendingWrite = m_pendingRead = 0;
 			m_connectionState = CONNECTION_STATE_OPEN;
 			m_receivedFirst = m_writeError = m_readError = false;
 			m_packetsSent = 0;
+			m_writeStart = 0;
 			m_timeConnected = time(NULL);
 			m_protocol = NULL;
 
@@ -137,17 +145,27 @@ class Connection : public std::enable_shared_from_this<Connection>
 		void handle(Protocol* protocol);
 		void accept();
 
-		bool send(OutputMessage_ptr msg);
+		// corked messages are only queued, they go out with the next flush; while
+		// a write is in flight the message goes back to the pool and keeps growing
+		bool send(OutputMessage_ptr msg, bool corked = false);
+		// crypto worker, runs the protocol on a copy of the first message and resumes reading
+		void handleFirstMessage(NetworkMessage& msg);
+		void flush();
 		void close();
 
+		// milliseconds the write in flight has been waiting for the client, 0 when idle
+		int64_t getWriteStall() const;
+
 		int32_t addRef() {return ++m_refCount;}
 		int32_t unRef() {return --m_refCount;}
 
+		static const ConnectionStats& getStats() {return m_stats;}
+
 	private:
 		void parseHeader(const boost::system::error_code& error);
 		void parsePacket(const boost::system::error_code& error);
 
-		void onWrite(OutputMessage_ptr msg, const boost::system::error_code& error);
+		void onWrite(const boost::system::error_code& error);
 		void onStop();
 
 		void handleReadError(const boost::system::error_code& error);
@@ -163,7 +181,7 @@ class Connection : public std::enable_shared_from_this<Connection>
 		void onReadTimeout();
 		void onWriteTimeout();
 
-		void internalSend(OutputMessage_ptr msg);
+		void internalSend();
 		void closeSocket();
 
 		NetworkMessage m_msg;
@@ -173,9 +191,16 @@ class Connection : public std::enable_shared_from_this<Connection>
 		boost::asio::deadline_timer m_readTimer, m_writeTimer;
 
 		boost::asio::io_service& m_service;
+		// keeps the handlers of this connection in order when several threads run m_service
+		boost::asio::io_service::strand m_strand;
 		ServicePort_ptr m_servicePort;
 		bool m_receivedFirst, m_writeError, m_readError;
 
+		// waiting for the next write, and owned by the write in flight
+		std::vector<OutputMessage_ptr> m_writeQueue, m_writeBatch;
+		std::vector<boost::asio::const_buffer> m_writeBuffers;
+		std::atomic<int64_t> m_writeStart;
+
 		int32_t m_pendingWrite, m_pendingRead;
 		ConnectionState_t m_connectionState;
 		uint32_t m_refCount;
@@ -184,6 +209,7 @@ class Connection : public std::enable_shared_from_this<Connection>
 		uint32_t m_packetsSent;
 	
 		static bool m_logError;
+		static ConnectionStats m_stats;
 		std::recursive_mutex m_connectionLock;
 };
 
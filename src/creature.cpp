@@ -30,6 +30,7 @@
 #include "configmanager.h"
 #include "game.h"
 #include "scheduler.h"
+#include "pathfinding.h"
 
 std::recursive_mutex AutoId::lock;
 uint32_t AutoId::count = 1000;
@@ -39,6 +40,23 @@ extern Game g_game;
 extern ConfigManager g_config;
 extern CreatureEvents* g_creatureEvents;
 
+MapCacheStats Creature::mapCacheStats;
+
+//items that can change whether a creature may walk onto their tile
+static bool isWalkCacheItem(const ItemType& iType)
+{
+	if(iType.blockSolid || iType.blockPathFind || iType.isGroundTile() || iType.isMagicField() || iType.isTeleport())
+		return true;
+
+	for(int32_t i = 0; i < CHANGE_LAST; ++i)
+	{
+		if(iType.floorChange[i])
+			return true;
+	}
+
+	return false;
+}
+
 Creature::Creature()
 {
 	id = 0;
@@ -72,9 +90,11 @@ Creature::Creature()
 	eventWalk = 0;
 	cancelNextWalk = false;
 	forceUpdateFollowPath = false;
+	pathRequestId = 0;
 	isMapLoaded = false;
 	isUpdatingPath = false;
 	checked = false;
+	suspended = false;
 	memset(localMapCache, false, sizeof(localMapCache));
 
 	attackedCreature = NULL;
@@ -84,6 +104,8 @@ Creature::Creature()
 	blockTicks = 0;
 	walkUpdateTicks = 0;
 	checkVector = -1;
+	thinkTier = THINKTIER_FULL;
+	thinkTicks = 0;
 
 	onIdleStatus();
 }
@@ -338,7 +360,7 @@ void Creature::addEventWalk(bool firstStep/* = false*/)
 	if(ticks == 1)
 		g_game.checkCreatureWalk(getID());
 
-	eventWalk = g_scheduler.addEvent(createSchedulerTask(std::max((int64_t)SCHEDULER_MINTICKS, ticks),
+	eventWalk = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Creature::addEventWalk", std::max((int64_t)SCHEDULER_MINTICKS, ticks),
 		std::bind(&Game::checkCreatureWalk, &g_game, id)));
 }
 
@@ -353,18 +375,38 @@ void Creature::stopEventWalk()
 
 void Creature::updateMapCache()
 {
+	++mapCacheStats.full;
 	const Position& pos = getPosition();
-	Position dest(0, 0, pos.z);
+	int32_t startX = pos.x - (mapWalkWidth - 1) / 2, startY = pos.y - (mapWalkHeight - 1) / 2;
 
-	Tile* tile = NULL;
-	for(int32_t y = -((mapWalkHeight - 1) / 2); y <= ((mapWalkHeight - 1) / 2); ++y)
+	//the floor bits answer most tiles, only the rest is asked through __queryAdd
+	uint8_t states[mapWalkWidth];
+	for(int32_t y = 0; y < mapWalkHeight; ++y)
 	{
-		for(int32_t x = -((mapWalkWidth - 1) / 2); x <= ((mapWalkWidth - 1) / 2); ++x)
+		g_game.getMap()->getPathStates(startX, startY + y, pos.z, mapWalkWidth, states, this);
+		for(int32_t x = 0; x < mapWalkWidth; ++x)
 		{
-			dest.x = pos.x + x;
-			dest.y = pos.y + y;
-			if((tile = g_game.getTile(dest)))
-				updateTileCache(tile, dest);
+			if(states[x] != PATHSTATE_CHECK)
+				localMapCache[y][x] = (states[x] == PATHSTATE_FREE);
+			else if(Tile* tile = g_game.getTile(startX + x, startY + y, pos.z))
+				updateTileCache(tile, x - (mapWalkWidth - 1) / 2, y - (mapWalkHeight - 1) / 2);
+		}
+	}
+}
+
+void Creature::updateMapCache(tilebit_t bit)
+{
+	++mapCacheStats.partial;
+	const Position& pos = getPosition();
+	int32_t startX = pos.x - (mapWalkWidth - 1) / 2, startY = pos.y - (mapWalkHeight - 1) / 2;
+	for(int32_t y = 0; y < mapWalkHeight; ++y)
+	{
+		uint32_t row = g_game.getMap()->getTileBits(startX, startY + y, pos.z, mapWalkWidth, bit);
+		for(int32_t x = 0; row; ++x, row >>= 1)
+		{
+			if(row & 1)
+				updateTileCache(g_game.getTile(startX + x, startY + y, pos.z),
+					x - (mapWalkWidth - 1) / 2, y - (mapWalkHeight - 1) / 2);
 		}
 	}
 }
@@ -385,9 +427,14 @@ void Creature::updateTileCache(const Tile* tile, int32_t dx, int32_t dy)
 {
 	if((std::abs(dx) <= (mapWalkWidth - 1) / 2) && (std::abs(dy) <= (mapWalkHeight - 1) / 2))
 	{
+		++mapCacheStats.tiles;
 		int32_t x = (mapWalkWidth - 1) / 2 + dx, y = (mapWalkHeight - 1) / 2 + dy;
-		localMapCache[y][x] = (tile && tile->__queryAdd(0, this, 1,
-			FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RET_NOERROR);
+		PathState_t state = (tile ? tile->getPathState(this) : PATHSTATE_BLOCKED);
+		if(state == PATHSTATE_CHECK)
+			localMapCache[y][x] = (tile->__queryAdd(0, this, 1,
+				FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RET_NOERROR);
+		else
+			localMapCache[y][x] = (state == PATHSTATE_FREE);
 	}
 #ifdef __DEBUG__
 	else
@@ -446,24 +493,22 @@ int32_t Creature::getWalkCache(const Position& pos) const
 	return 2;
 }
 
-void Creature::onAddTileItem(const Tile* tile, const Position& pos, const Item*)
+void Creature::onAddTileItem(const Tile* tile, const Position& pos, const Item* item)
 {
-	if(isMapLoaded && pos.z == getPosition().z)
+	if(isMapLoaded && pos.z == getPosition().z && isWalkCacheItem(Item::items[item->getID()]))
 		updateTileCache(tile, pos);
 }
 
 void Creature::onUpdateTileItem(const Tile* tile, const Position& pos, const Item*,
 	const ItemType& oldType, const Item*, const ItemType& newType)
 {
-	if(isMapLoaded && (oldType.blockSolid || oldType.blockPathFind || newType.blockPathFind
-		|| newType.blockSolid) && pos.z == getPosition().z)
+	if(isMapLoaded && (isWalkCacheItem(oldType) || isWalkCacheItem(newType)) && pos.z == getPosition().z)
 		updateTileCache(tile, pos);
 }
 
 void Creature::onRemoveTileItem(const Tile* tile, const Position& pos, const ItemType& iType, const Item*)
 {
-	if(isMapLoaded && (iType.blockSolid || iType.blockPathFind ||
-		iType.isGroundTile()) && pos.z == getPosition().z)
+	if(isMapLoaded && isWalkCacheItem(iType) && pos.z == getPosition().z)
 		updateTileCache(tile, pos);
 }
 
@@ -656,7 +701,7 @@ void Creature::onCreatureMove(const Creature* creature, const Tile* newTile, con
 		if(hasFollowPath)
 		{
 			isUpdatingPath = true;
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("Creature::onCreatureMove",
 				std::bind(&Game::updateCreatureWalk, &g_game, getID())));
 		}
 
@@ -669,7 +714,7 @@ void Creature::onCreatureMove(const Creature* creature, const Tile* newTile, con
 		if(newPos.z == oldPos.z && canSee(attackedCreature->getPosition()))
 		{
 			if(hasExtraSwing()) //our target is moving lets see if we can get in hit
-				g_dispatcher.addTask(createTask(
+				g_dispatcher.addTask(createTaskWithOrigin("Creature::onCreatureMove",
 					std::bind(&Game::checkCreatureAttack, &g_game, getID())));
 
 			if(newTile->getZone() != oldTile->getZone())
@@ -1047,18 +1092,61 @@ void Creature::goToFollowCreature()
 	{
 		FindPathParams fpp;
 		getPathSearchParams(followCreature, fpp);
-		if(g_game.getPathToEx(this, followCreature->getPosition(), listWalkDir, fpp))
+		std::list<Direction> dirList;
+		if(g_game.getPathByFlowField(this, followCreature, dirList, fpp))
 		{
+			//walked down the field shared by everyone chasing this creature
+			++pathRequestId;
+			listWalkDir.swap(dirList);
 			hasFollowPath = true;
 			startAutoWalk(listWalkDir);
 		}
+		else if(fpp.maxSearchDist != -1 && g_pathfinding.isRunning())
+		{
+			//searched on a pathfinding worker, the result comes back through onFollowPath
+			g_pathfinding.addJob(std::make_shared<PathJob>(this, followCreature, ++pathRequestId, fpp));
+			return;
+		}
 		else
-			hasFollowPath = false;
+		{
+			++pathRequestId; //results of searches still on a worker are outdated now
+			if(g_game.getPathToEx(this, followCreature->getPosition(), listWalkDir, fpp))
+			{
+				hasFollowPath = true;
+				startAutoWalk(listWalkDir);
+			}
+			else
+				hasFollowPath = false;
+		}
 	}
 
 	onFollowCreatureComplete(followCreature);
 }
 
+void Creature::onFollowPath(PathJob& job)
+{
+	if(job.requestId != pathRequestId || !followCreature || followCreature->getID() != job.targetId)
+		return; //a newer search was requested or we stopped following
+
+	if(getPosition() != job.snapshot.getStartPos())
+	{
+		//we moved while the path was searched, it no longer starts here
+		goToFollowCreature();
+		return;
+	}
+
+	listWalkDir.swap(job.dirList);
+	if(job.found)
+	{
+		hasFollowPath = true;
+		startAutoWalk(listWalkDir);
+	}
+	else
+		hasFollowPath = false;
+
+	onFollowCreatureComplete(followCreature);
+}
+
 bool Creature::setFollowCreature(Creature* creature, bool /*fullPathSearch = false*/)
 {
 	if(creature)
@@ -1620,6 +1708,13 @@ CreatureEventList Creature::getCreatureEvents(CreatureEventType_t type)
 FrozenPathingConditionCall::FrozenPathingConditionCall(const Position& _targetPos)
 {
 	targetPos = _targetPos;
+	snapshot = NULL;
+}
+
+FrozenPathingConditionCall::FrozenPathingConditionCall(const PathSnapshot& _snapshot)
+{
+	targetPos = _snapshot.getTargetPos();
+	snapshot = &_snapshot;
 }
 
 bool FrozenPathingConditionCall::isInRange(const Position& startPos, const Position& testPos,
@@ -1644,7 +1739,7 @@ bool FrozenPathingConditionCall::operator()(const Position& startPos, const Posi
 	if(!isInRange(startPos, testPos, fpp))
 		return false;
 
-	if(fpp.clearSight && !g_game.isSightClear(testPos, targetPos, true))
+	if(fpp.clearSight && !(snapshot ? snapshot->isSightClear(testPos) : g_game.isSightClear(testPos, targetPos, true)))
 		return false;
 
 	int32_t testDist = std::max(std::abs(targetPos.x - testPos.x), std::abs(targetPos.y - testPos.y));
@@ -67,14 +67,23 @@ struct FindPathParams
 {
 	bool fullPathSearch, clearSight, allowDiagonal, keepDistance;
 	int32_t maxSearchDist, minTargetDist, maxTargetDist;
+	uint32_t maxNodes;
 	FindPathParams()
 	{
 		fullPathSearch = clearSight = allowDiagonal = true;
 		maxSearchDist = minTargetDist = maxTargetDist = -1;
 		keepDistance = false;
+		maxNodes = MAX_NODES;
 	}
 };
 
+// how often the local walk caches were refreshed, see Creature::updateMapCache
+struct MapCacheStats
+{
+	MapCacheStats(): full(0), partial(0), tiles(0) {}
+	uint64_t full, partial, tiles;
+};
+
 struct DeathLessThan;
 struct DeathEntry
 {
@@ -145,10 +154,22 @@ class Container;
 #define EVENT_CREATURE_THINK_INTERVAL 500
 #define EVENT_CHECK_CREATURE_INTERVAL (EVENT_CREATURE_THINK_INTERVAL / EVENT_CREATURECOUNT)
 
+enum ThinkTier_t
+{
+	THINKTIER_FULL = 0, //on a player screen, fighting or under conditions
+	THINKTIER_EDGE, //players around, but none has it on screen
+	THINKTIER_FAR, //no player within spectator range
+	THINKTIER_LAST
+};
+
+class PathSnapshot;
+struct PathJob;
+
 class FrozenPathingConditionCall
 {
 	public:
 		FrozenPathingConditionCall(const Position& _targetPos);
+		FrozenPathingConditionCall(const PathSnapshot& _snapshot);
 		virtual ~FrozenPathingConditionCall() {}
 
 		virtual bool operator()(const Position& startPos, const Position& testPos,
@@ -159,6 +180,7 @@ class FrozenPathingConditionCall
 
 	protected:
 		Position targetPos;
+		const PathSnapshot* snapshot;
 };
 
 class Creature : public AutoId, virtual public Thing
@@ -196,6 +218,10 @@ class Creature : public AutoId, virtual public Thing
 
 		void setRemoved() {removed = true;}
 		virtual bool isRemoved() const {return removed;}
+		// wants to think but sits in a region without players
+		bool isSuspended() const {return suspended;}
+		// has to think at full rate whatever players are around
+		virtual bool hasThinkPriority() const {return followCreature || attackedCreature || !conditions.empty();}
 
 		virtual uint32_t rangeId() = 0;
 		virtual void removeList() = 0;
@@ -272,6 +298,7 @@ class Creature : public AutoId, virtual public Thing
 		void addEventWalk(bool firstStep = false);
 		void stopEventWalk();
 		void goToFollowCreature();
+		void onFollowPath(PathJob& job);
 
 		//walk events
 		virtual void onWalk(Direction& dir);
@@ -457,11 +484,13 @@ class Creature : public AutoId, virtual public Thing
 		const Position& getLastPosition() {return lastPosition;}
 		void setLastPosition(Position newLastPos) {lastPosition = newLastPos;}
 		static bool canSee(const Position& myPos, const Position& pos, uint32_t viewRangeX, uint32_t viewRangeY);
+		static const MapCacheStats& getMapCacheStats() {return mapCacheStats;}
 
 	protected:
 		static const int32_t mapWalkWidth = Map::maxViewportX * 2 + 1;
 		static const int32_t mapWalkHeight = Map::maxViewportY * 2 + 1;
 		bool localMapCache[mapWalkHeight][mapWalkWidth];
+		static MapCacheStats mapCacheStats;
 
 		virtual bool useCacheMap() const {return false;}
 
@@ -471,9 +500,12 @@ class Creature : public AutoId, virtual public Thing
 		bool isMapLoaded;
 		bool isUpdatingPath;
 		bool checked;
+		bool suspended;
 		StorageMap storageMap;
 
 		int32_t checkVector;
+		ThinkTier_t thinkTier;
+		uint32_t thinkTicks;
 		int32_t health, healthMax;
 		int32_t mana, manaMax;
 
@@ -511,6 +543,7 @@ class Creature : public AutoId, virtual public Thing
 		uint32_t walkUpdateTicks;
 		bool hasFollowPath;
 		bool forceUpdateFollowPath;
+		uint32_t pathRequestId;
 
 		//combat variables
 		Creature* attackedCreature;
@@ -540,6 +573,8 @@ class Creature : public AutoId, virtual public Thing
 		void validateMapCache();
 		#endif
 		void updateMapCache();
+		// only the cells whose tiles have bit set, for changes that cannot affect the others
+		void updateMapCache(tilebit_t bit);
 
 		void updateTileCache(const Tile* tile);
 		void updateTileCache(const Tile* tile, int32_t dx, int32_t dy);
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "cryptopool.h"
+
+#include "taskprofiler.h"
+
+void CryptoPool::start(uint32_t threads, uint32_t queueLimit)
+{
+	if(m_running || !threads)
+		return;
+
+	m_queueLimit = std::max((uint32_t)1, queueLimit);
+	m_running = true;
+	for(uint32_t i = 0; i < threads; ++i)
+		m_threads.push_back(std::thread(&CryptoPool::threadMain, this));
+}
+
+void CryptoPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(m_jobLock);
+		if(!m_running)
+			return;
+
+		m_running = false;
+		m_stats.dropped += m_jobs.size();
+		m_stats.queueSize = 0;
+		m_jobs.clear();
+	}
+
+	m_jobSignal.notify_all();
+	for(std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+	{
+		if(it->joinable())
+			it->join();
+	}
+
+	m_threads.clear();
+}
+
+bool CryptoPool::addJob(Connection_ptr connection, NetworkMessage& msg)
+{
+	{
+		std::lock_guard<std::mutex> lockClass(m_jobLock);
+		if(!m_running || m_jobs.size() >= m_queueLimit)
+		{
+			++m_stats.dropped;
+			return false;
+		}
+
+		std::unique_ptr<CryptoJob> job(new CryptoJob());
+		job->connection = connection;
+		// only the received bytes, not the whole buffer
+		memcpy(job->msg.buffer(), msg.buffer(), msg.size());
+		job->msg.setSize(msg.size());
+		job->msg.setPosition(msg.position());
+		job->queued = TaskProfiler::getTime();
+
+		m_jobs.push_back(std::move(job));
+		uint32_t size = ++m_stats.queueSize;
+		if(size > m_stats.maxQueueSize)
+			m_stats.maxQueueSize = size;
+	}
+
+	m_jobSignal.notify_one();
+	return true;
+}
+
+void CryptoPool::threadMain()
+{
+	std::unique_lock<std::mutex> jobLockUnique(m_jobLock, std::defer_lock);
+	while(true)
+	{
+		jobLockUnique.lock();
+		m_jobSignal.wait(jobLockUnique, [this] {return !m_running || !m_jobs.empty();});
+		if(!m_running)
+			break;
+
+		std::unique_ptr<CryptoJob> job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		--m_stats.queueSize;
+		jobLockUnique.unlock();
+
+		int64_t start = TaskProfiler::getTime();
+		job->connection->handleFirstMessage(job->msg);
+
+		uint32_t runTime = TaskProfiler::getTime() - start, maxRunTime = m_stats.maxRunTime.load(std::memory_order_relaxed);
+		while(runTime > maxRunTime && !m_stats.maxRunTime.compare_exchange_weak(maxRunTime, runTime, std::memory_order_relaxed));
+
+		m_stats.waitTime += start - job->queued;
+		m_stats.runTime += runTime;
+
+		++m_stats.jobs;
+	}
+}
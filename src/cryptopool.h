@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __CRYPTOPOOL__
+#define __CRYPTOPOOL__
+#include "connection.h"
+#include "networkmessage.h"
+
+// The RSA encrypted first message of a login, copied off the connection
+// so that the private key operation runs on a crypto worker.
+struct CryptoJob
+{
+	Connection_ptr connection;
+	NetworkMessage msg;
+	int64_t queued;
+};
+
+struct CryptoStats
+{
+	// times are in microseconds, run covers the whole first message handler
+	std::atomic<uint64_t> jobs{0}, dropped{0}, waitTime{0}, runTime{0};
+	std::atomic<uint32_t> queueSize{0}, maxQueueSize{0}, maxRunTime{0};
+};
+
+class CryptoPool
+{
+	public:
+		CryptoPool(): m_queueLimit(0) {}
+		virtual ~CryptoPool() {shutdown();}
+
+		// threads = 0 keeps decrypting on the network threads
+		void start(uint32_t threads, uint32_t queueLimit);
+		void shutdown();
+
+		bool isRunning() const {return m_running;}
+		uint32_t getThreadCount() const {return m_threads.size();}
+
+		// false when the queue is full, the connection should be dropped then
+		bool addJob(Connection_ptr connection, NetworkMessage& msg);
+
+		const CryptoStats& getStats() const {return m_stats;}
+		void resetMaxQueueSize() {m_stats.maxQueueSize = m_stats.queueSize.load();}
+
+	protected:
+		void threadMain();
+
+		std::mutex m_jobLock;
+		std::condition_variable m_jobSignal;
+		std::deque<std::unique_ptr<CryptoJob> > m_jobs;
+		uint32_t m_queueLimit;
+
+		std::vector<std::thread> m_threads;
+		std::atomic<bool> m_running{false};
+
+		CryptoStats m_stats;
+};
+extern CryptoPool g_cryptoPool;
+#endif
@@ -67,7 +67,7 @@ DatabaseMySQL::DatabaseMySQL() :
 
 	timeout = g_config.getNumber(ConfigManager::SQL_KEEPALIVE) * 1000;
 	if(timeout)
-		m_timeoutTask = g_scheduler.addEvent(createSchedulerTask(timeout,
+		m_timeoutTask = g_scheduler.addEvent(createSchedulerTaskWithOrigin("DatabaseMySQL::DatabaseMySQL", timeout,
 			std::bind(&DatabaseMySQL::keepAlive, this)));
 
 	if(!g_config.getBool(ConfigManager::HOUSE_STORAGE))
@@ -221,7 +221,7 @@ void DatabaseMySQL::keepAlive()
 			m_connected = false;
 	}
 
-	g_scheduler.addEvent(createSchedulerTask(timeout,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("DatabaseMySQL::keepAlive", timeout,
 		std::bind(&DatabaseMySQL::keepAlive, this)));
 }
 
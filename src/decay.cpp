@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+#include "decay.h"
+
+#include "tools.h"
+
+void DecayWheel::add(Item* item, int64_t expiry)
+{
+	if(!m_nextTick)
+		m_nextTick = OTSYS_TIME() / m_tickLength;
+
+	insert(DecayEntry(item, expiry));
+	++m_size;
+	++m_stats.scheduled;
+}
+
+void DecayWheel::insert(const DecayEntry& entry)
+{
+	//never earlier than the expiry, and never into a tick already passed
+	int64_t tick = std::max(m_nextTick, (entry.expiry + m_tickLength - 1) / m_tickLength),
+		delta = tick - m_nextTick, range = (int64_t)1 << (DECAY_WHEEL_BITS * DECAY_WHEEL_LEVELS);
+	if(delta >= range)
+	{
+		//out of reach, it is put back in when its slot comes up
+		tick = m_nextTick + range - 1;
+		delta = range - 1;
+	}
+
+	int32_t level = 0;
+	while(delta >= ((int64_t)1 << (DECAY_WHEEL_BITS * (level + 1))))
+		++level;
+
+	m_slots[level][(tick >> (DECAY_WHEEL_BITS * level)) & DECAY_WHEEL_MASK].push_back(entry);
+}
+
+void DecayWheel::advance(int64_t now, DecayEntryList& list)
+{
+	int64_t lastTick = now / m_tickLength;
+	if(!m_nextTick)
+		m_nextTick = lastTick;
+
+	for(; m_nextTick <= lastTick; ++m_nextTick)
+	{
+		for(int32_t level = 1; level < DECAY_WHEEL_LEVELS; ++level)
+		{
+			if(m_nextTick & (((int64_t)1 << (DECAY_WHEEL_BITS * level)) - 1))
+				break;
+
+			DecayEntryList cascade;
+			cascade.swap(m_slots[level][(m_nextTick >> (DECAY_WHEEL_BITS * level)) & DECAY_WHEEL_MASK]);
+			for(DecayEntryList::iterator it = cascade.begin(); it != cascade.end(); ++it)
+				insert(*it);
+
+			m_stats.cascaded += cascade.size();
+		}
+
+		DecayEntryList& slot = m_slots[0][m_nextTick & DECAY_WHEEL_MASK];
+		if(slot.empty())
+			continue;
+
+		list.insert(list.end(), slot.begin(), slot.end());
+		m_size -= slot.size();
+		slot.clear();
+	}
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __DECAY__
+#define __DECAY__
+
+class Item;
+
+// every level has DECAY_WHEEL_SIZE slots, each one as long as a whole
+// level below, four levels reach further than any int32_t duration
+#define DECAY_WHEEL_BITS 6
+#define DECAY_WHEEL_SIZE (1 << DECAY_WHEEL_BITS)
+#define DECAY_WHEEL_MASK (DECAY_WHEEL_SIZE - 1)
+#define DECAY_WHEEL_LEVELS 4
+
+struct DecayEntry
+{
+	DecayEntry(Item* _item, int64_t _expiry): item(_item), expiry(_expiry) {}
+
+	Item* item;
+	// Item::getDecayExpiry() when scheduled, the entry is stale once they differ
+	int64_t expiry;
+};
+typedef std::vector<DecayEntry> DecayEntryList;
+
+struct DecayStats
+{
+	DecayStats(): scheduled(0), expired(0), stale(0), cascaded(0) {}
+	uint64_t scheduled, expired, stale, cascaded;
+};
+
+// Hierarchical timing wheel keyed by absolute expiry time. An advance only
+// touches the slot of each tick that passed and, every DECAY_WHEEL_SIZE
+// ticks, the slot of the next level that is spread over the levels below.
+class DecayWheel
+{
+	public:
+		DecayWheel(uint32_t tickLength): m_tickLength(tickLength), m_nextTick(0), m_size(0) {}
+
+		void add(Item* item, int64_t expiry);
+		// moves the entries that expired by now to list
+		void advance(int64_t now, DecayEntryList& list);
+
+		uint32_t size() const {return m_size;}
+		DecayStats& getStats() {return m_stats;}
+
+	protected:
+		void insert(const DecayEntry& entry);
+
+		uint32_t m_tickLength;
+		// first tick not advanced over yet
+		int64_t m_nextTick;
+		uint32_t m_size;
+
+		DecayEntryList m_slots[DECAY_WHEEL_LEVELS][DECAY_WHEEL_SIZE];
+		DecayStats m_stats;
+};
+#endif
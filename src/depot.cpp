@@ -19,6 +19,10 @@
 #include "depot.h"
 #include "tools.h"
 
+#include "game.h"
+
+extern Game g_game;
+
 Depot::Depot(uint16_t type):
 	Container(type)
 {
@@ -76,6 +80,9 @@ ReturnValue Depot::__queryMaxCount(int32_t index, const Thing* thing, uint32_t c
 void Depot::postAddNotification(Creature* actor, Thing* thing, const Cylinder* oldParent,
 	int32_t index, cylinderlink_t /*link = LINK_OWNER*/)
 {
+	if(Item* item = thing->getItem())
+		g_game.updateStoredDecay(item);
+
 	if(getParent())
 		getParent()->postAddNotification(actor, thing, oldParent, index, LINK_PARENT);
 }
@@ -83,6 +90,10 @@ void Depot::postAddNotification(Creature* actor, Thing* thing, const Cylinder* o
 void Depot::postRemoveNotification(Creature* actor, Thing* thing, const Cylinder* newParent,
 	int32_t index, bool isCompleteRemoval, cylinderlink_t /*link = LINK_OWNER*/)
 {
+	Item* item = thing->getItem();
+	if(item && !isCompleteRemoval)
+		g_game.updateStoredDecay(item);
+
 	if(getParent())
 		getParent()->postRemoveNotification(actor, thing, newParent,
 			index, isCompleteRemoval, LINK_PARENT);
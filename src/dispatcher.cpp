@@ -19,11 +19,171 @@
 #include "dispatcher.h"
 
 #include "outputmessage.h"
+#include "taskprofiler.h"
 #include "game.h"
 #include "tools.h"
 
 extern Game g_game;
 
+thread_local TaskPool::LocalCache TaskPool::m_cache;
+std::mutex TaskPool::m_poolLock;
+std::vector<TaskPool::Block*> TaskPool::m_batches;
+std::atomic<uint64_t> TaskPool::m_blockCount{0};
+
+void* TaskPool::allocate(size_t size)
+{
+	if(size > TASK_POOL_BLOCK_SIZE)
+		return ::operator new(size);
+
+	LocalCache& cache = m_cache;
+	if(!cache.head && !getBatch(cache))
+	{
+		++m_blockCount;
+		return ::operator new(TASK_POOL_BLOCK_SIZE);
+	}
+
+	Block* block = cache.head;
+	cache.head = block->next;
+	--cache.count;
+	return block;
+}
+
+void TaskPool::deallocate(void* block, size_t size)
+{
+	if(size > TASK_POOL_BLOCK_SIZE)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	LocalCache& cache = m_cache;
+	Block* freed = static_cast<Block*>(block);
+	freed->next = cache.head;
+	cache.head = freed;
+	// the dispatcher thread frees nearly all tasks, hand the surplus back
+	if(++cache.count >= TASK_POOL_BATCH * 2)
+		putBatch(cache);
+}
+
+void TaskPool::putBatch(LocalCache& cache)
+{
+	Block* batch = cache.head;
+	Block* last = batch;
+	for(uint32_t i = 1; i < TASK_POOL_BATCH; ++i)
+		last = last->next;
+
+	cache.head = last->next;
+	cache.count -= TASK_POOL_BATCH;
+
+	last->next = NULL;
+	std::lock_guard<std::mutex> lockClass(m_poolLock);
+	m_batches.push_back(batch);
+}
+
+bool TaskPool::getBatch(LocalCache& cache)
+{
+	std::lock_guard<std::mutex> lockClass(m_poolLock);
+	if(m_batches.empty())
+		return false;
+
+	cache.head = m_batches.back();
+	cache.count = TASK_POOL_BATCH;
+
+	m_batches.pop_back();
+	return true;
+}
+
+TaskPool::LocalCache::~LocalCache()
+{
+	// return whatever is left to the shared pool
+	while(count >= TASK_POOL_BATCH)
+		TaskPool::putBatch(*this);
+
+	while(head)
+	{
+		Block* next = head->next;
+		::operator delete(head);
+		head = next;
+		--m_blockCount;
+	}
+}
+
+uint32_t TaskQueue::push(Task* task)
+{
+	uint32_t retries = 0;
+	Task* head = m_head.load(std::memory_order_relaxed);
+	do
+	{
+		task->m_next = head;
+		if(m_head.compare_exchange_weak(head, task))
+			break;
+
+		++retries;
+	}
+	while(true);
+	return retries;
+}
+
+Task* TaskQueue::popAll(bool fifo/* = true*/)
+{
+	if(!m_head.load(std::memory_order_relaxed))
+		return NULL;
+
+	// the queue is a stack, reverse it to get the insertion order back
+	Task* task = m_head.exchange(NULL, std::memory_order_acquire);
+	if(!fifo)
+		return task;
+
+	Task* list = NULL;
+	while(task)
+	{
+		Task* next = task->m_next;
+		task->m_next = list;
+		list = task;
+		task = next;
+	}
+
+	return list;
+}
+
+Task* Dispatcher::popTask()
+{
+	// front tasks queued meanwhile go before the rest of the front batch
+	if(Task* front = m_frontQueue.popAll(false))
+	{
+		Task* last = front;
+		while(last->m_next)
+			last = last->m_next;
+
+		last->m_next = m_frontBatch;
+		m_frontBatch = front;
+	}
+
+	Task* task = NULL;
+	if(m_frontBatch)
+	{
+		task = m_frontBatch;
+		m_frontBatch = task->m_next;
+	}
+	else
+	{
+		if(!m_taskBatch)
+		{
+			if(!(m_taskBatch = m_taskQueue.popAll()))
+				return NULL;
+
+			++m_stats.batches;
+		}
+
+		task = m_taskBatch;
+		m_taskBatch = task->m_next;
+	}
+
+	task->m_next = NULL;
+	--m_stats.queueSize;
+	return task;
+}
+
 void Dispatcher::threadMain()
 {
 	#if defined __EXCEPTION_TRACER__
@@ -32,29 +192,32 @@ void Dispatcher::threadMain()
 	#endif
 
 	OutputMessagePool* outputPool = NULL;
+	TaskProfiler* profiler = TaskProfiler::getInstance();
 	std::unique_lock<std::mutex> taskLockUnique(m_taskLock, std::defer_lock);
 	while(m_threadState != STATE_TERMINATED)
 	{
-		Task* task = NULL;
-		// check if there are tasks waiting
-		taskLockUnique.lock();
-		if(m_taskList.empty()) //if the list is empty wait for signal
-			m_taskSignal.wait(taskLockUnique);
-
-		if(!m_taskList.empty() && m_threadState != STATE_TERMINATED)
+		Task* task = popTask();
+		if(!task)
 		{
-			// take the first task
-			task = m_taskList.front();
-			m_taskList.pop_front();
-		}
+			// nothing to do, announce that we are going to sleep and check
+			// again, so that a producer either sees the flag or we see its task
+			taskLockUnique.lock();
+			m_sleeping = true;
+			if(m_frontQueue.empty() && m_taskQueue.empty() && m_threadState != STATE_TERMINATED)
+				m_taskSignal.wait(taskLockUnique);
 
-		taskLockUnique.unlock();
-		// finally execute the task...
-		if(!task)
+			m_sleeping = false;
+			taskLockUnique.unlock();
 			continue;
+		}
 
+		// finally execute the task...
 		if(!task->hasExpired())
 		{
+			int64_t start = 0;
+			if(profiler->isEnabled())
+				start = TaskProfiler::getTime();
+
 			if((outputPool = OutputMessagePool::getInstance()))
 				outputPool->startExecutionFrame();
 
@@ -62,9 +225,12 @@ void Dispatcher::threadMain()
 			if(outputPool)
 				outputPool->sendAll();
 
-			g_game.clearSpectatorCache();
+			g_game.releaseTaskCaches();
+			if(start && task->m_queued)
+				profiler->record(task->getOrigin(), start - task->m_queued, TaskProfiler::getTime() - start);
 		}
 
+		++m_stats.tasks;
 		delete task;
 	}
 
@@ -75,42 +241,51 @@ void Dispatcher::threadMain()
 
 void Dispatcher::addTask(Task* task, bool front/* = false*/)
 {
-	bool signal = false;
-	m_taskLock.lock();
-	if(m_threadState == STATE_RUNNING)
+	// announced before the state is read, see shutdown
+	++m_pushing;
+	if(m_threadState != STATE_RUNNING)
 	{
-		signal = m_taskList.empty();
-		if(front)
-			m_taskList.push_front(task);
-		else
-			m_taskList.push_back(task);
-	}
-	#ifdef __DEBUG_SCHEDULER__
-	else
+		--m_pushing;
+		#ifdef __DEBUG_SCHEDULER__
 		std::clog << "[Error - Dispatcher::addTask] Dispatcher thread is terminated." << std::endl;
-	#endif
+		#endif
+		delete task;
+		return;
+	}
 
-	m_taskLock.unlock();
-	// send a signal if the list was empty
-	if(signal)
+	if(TaskProfiler::getInstance()->isEnabled())
+		task->m_queued = TaskProfiler::getTime();
+
+	uint32_t size = ++m_stats.queueSize, maxSize = m_stats.maxQueueSize.load(std::memory_order_relaxed);
+	while(size > maxSize && !m_stats.maxQueueSize.compare_exchange_weak(maxSize, size, std::memory_order_relaxed));
+
+	if(uint32_t retries = (front ? m_frontQueue : m_taskQueue).push(task))
+		m_stats.contention += retries;
+
+	--m_pushing;
+
+	// the lock is only taken if the dispatcher thread is waiting for work
+	if(m_sleeping)
+	{
+		m_taskLock.lock();
+		m_taskLock.unlock();
+
+		++m_stats.wakeups;
 		m_taskSignal.notify_one();
+	}
 }
 
 void Dispatcher::flush()
 {
-	Task* task = NULL;
 	OutputMessagePool* outputPool = OutputMessagePool::getInstance();
-	while(!m_taskList.empty())
+	while(Task* task = popTask())
 	{
-		task = m_taskList.front();
-		m_taskList.pop_front();
-
 		(*task)();
 		delete task;
 		if(outputPool)
 			outputPool->sendAll();
 
-		g_game.clearSpectatorCache();
+		g_game.releaseTaskCaches();
 	}
 }
 
@@ -123,18 +298,16 @@ void Dispatcher::stop()
 
 void Dispatcher::shutdown()
 {
+	// called from within a task, so this is the dispatcher thread
 	m_taskLock.lock();
 	m_threadState = STATE_TERMINATED;
-
-	flush();
 	m_taskLock.unlock();
-}
 
-Task* createTask(std::function<void (void)> f)
-{
-	return new Task(std::move(f));
+	// an addTask that read the state before it changed is still pushing, every
+	// later one sees STATE_TERMINATED and drops its task
+	while(m_pushing)
+		std::this_thread::yield();
+
+	flush();
+	m_taskSignal.notify_one();
 }
-Task* createTask(uint32_t expiration, std::function<void (void)> f)
-{
-	return new Task(expiration, std::move(f));
-}
\ No newline at end of file
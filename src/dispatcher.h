@@ -23,16 +23,119 @@
 const int DISPATCHER_TASK_EXPIRATION = 2000;
 const auto SYSTEM_TIME_ZERO = std::chrono::system_clock::time_point(std::chrono::milliseconds(0));
 
+// size of the pooled task blocks, big enough for a SchedulerTask
+static constexpr size_t TASK_POOL_BLOCK_SIZE = 192;
+// amount of blocks a thread moves between its own cache and the shared pool at once
+static constexpr uint32_t TASK_POOL_BATCH = 64;
+
+// Freelist for Task and SchedulerTask objects, every thread keeps a small
+// cache and only touches the shared pool to exchange whole batches.
+class TaskPool
+{
+	public:
+		static void* allocate(size_t size);
+		static void deallocate(void* block, size_t size);
+
+		static uint64_t getBlockCount() {return m_blockCount;}
+
+	protected:
+		struct Block
+		{
+			Block* next;
+		};
+
+		struct LocalCache
+		{
+			~LocalCache();
+
+			Block* head = NULL;
+			uint32_t count = 0;
+		};
+
+		static void putBatch(LocalCache& cache);
+		static bool getBatch(LocalCache& cache);
+
+		static thread_local LocalCache m_cache;
+		static std::mutex m_poolLock;
+		static std::vector<Block*> m_batches;
+		static std::atomic<uint64_t> m_blockCount;
+};
+
+// Type erased void() callable, closures up to INLINE_SIZE bytes (which covers
+// the usual std::bind of a member function and a few arguments) are stored
+// in place instead of on the heap.
+class TaskFunction
+{
+	public:
+		static constexpr size_t INLINE_SIZE = 64;
+
+		template<typename F>
+		TaskFunction(F&& f)
+		{
+			typedef typename std::decay<F>::type Function;
+			init<Function>(std::forward<F>(f), std::integral_constant<bool, sizeof(Function) <= INLINE_SIZE
+				&& alignof(Function) <= alignof(std::max_align_t)>());
+		}
+		~TaskFunction() {m_destroy(m_object);}
+
+		// non-copyable
+		TaskFunction(const TaskFunction&) = delete;
+		TaskFunction& operator=(const TaskFunction&) = delete;
+
+		void operator()() {m_invoke(m_object);}
+
+	protected:
+		template<typename Function, typename F>
+		void init(F&& f, std::true_type)
+		{
+			m_object = new(&m_storage) Function(std::forward<F>(f));
+			m_invoke = &invoke<Function>;
+			m_destroy = &destroyInline<Function>;
+		}
+
+		template<typename Function, typename F>
+		void init(F&& f, std::false_type)
+		{
+			m_object = new Function(std::forward<F>(f));
+			m_invoke = &invoke<Function>;
+			m_destroy = &destroyHeap<Function>;
+		}
+
+		template<typename Function>
+		static void invoke(void* object) {(*static_cast<Function*>(object))();}
+		template<typename Function>
+		static void destroyInline(void* object) {static_cast<Function*>(object)->~Function();}
+		template<typename Function>
+		static void destroyHeap(void* object) {delete static_cast<Function*>(object);}
+
+		void* m_object;
+		void (*m_invoke)(void*);
+		void (*m_destroy)(void*);
+		typename std::aligned_storage<INLINE_SIZE, alignof(std::max_align_t)>::type m_storage;
+};
+
 class Task
 {
 	public:
-		explicit Task(std::function<void (void)>&& f) : m_f(std::move(f)) {}
-		Task(uint32_t ms, std::function<void (void)>&& f) :
-			m_expiration(std::chrono::system_clock::now() + std::chrono::milliseconds(ms)), m_f(std::move(f)) {}
+		template<typename F>
+		explicit Task(F&& f) : m_f(std::forward<F>(f)) {}
+		template<typename F>
+		Task(uint32_t ms, F&& f) :
+			m_expiration(std::chrono::system_clock::now() + std::chrono::milliseconds(ms)), m_f(std::forward<F>(f)) {}
 
 		virtual ~Task() {}
 		void operator()() {m_f();}
 
+		// non-copyable
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		static void* operator new(size_t size) {return TaskPool::allocate(size);}
+		static void operator delete(void* block, size_t size) {TaskPool::deallocate(block, size);}
+
+		void setOrigin(const char* origin) {m_origin = origin;}
+		const char* getOrigin() const {return m_origin;}
+
 		void unsetExpiration() {m_expiration = SYSTEM_TIME_ZERO;}
 		bool hasExpired() const
 		{
@@ -44,12 +147,54 @@ class Task
 
 	protected:
 		std::chrono::system_clock::time_point m_expiration = SYSTEM_TIME_ZERO;
-		std::function<void (void)> m_f;
+		TaskFunction m_f;
+
+		// static label of the code that created the task, used by TaskProfiler
+		const char* m_origin = "unknown";
+		int64_t m_queued = 0;
+
+		Task* m_next = NULL;
+		friend class TaskQueue;
+		friend class Dispatcher;
 };
 
-Task* createTask(std::function<void (void)> f);
+template<typename F>
+inline Task* createTaskWithOrigin(const char* origin, F&& f)
+{
+	Task* task = new Task(std::forward<F>(f));
+	task->setOrigin(origin);
+	return task;
+}
 
-Task* createTask(uint32_t expiration, std::function<void (void)> f);
+template<typename F>
+inline Task* createTaskWithOrigin(const char* origin, uint32_t expiration, F&& f)
+{
+	Task* task = new Task(expiration, std::forward<F>(f));
+	task->setOrigin(origin);
+	return task;
+}
+
+// Intrusive lock-free multi-producer/single-consumer queue, producers push
+// with a single CAS and the consumer takes the whole queue at once.
+class TaskQueue
+{
+	public:
+		// returns the amount of failed CAS attempts (contention)
+		uint32_t push(Task* task);
+		// returns the queued tasks as a chain, in FIFO order or newest first
+		Task* popAll(bool fifo = true);
+
+		bool empty() const {return !m_head.load();}
+
+	protected:
+		std::atomic<Task*> m_head{NULL};
+};
+
+struct DispatcherStats
+{
+	std::atomic<uint64_t> tasks{0}, batches{0}, wakeups{0}, contention{0};
+	std::atomic<uint32_t> queueSize{0}, maxQueueSize{0};
+};
 
 class Dispatcher : public ThreadHolder<Dispatcher>
 {
@@ -61,13 +206,28 @@ class Dispatcher : public ThreadHolder<Dispatcher>
 
 		void threadMain();
 
+		const DispatcherStats& getStats() const {return m_stats;}
+		void resetMaxQueueSize() {m_stats.maxQueueSize = m_stats.queueSize.load();}
+
 	protected:
 		void flush();
+		Task* popTask();
 
 		std::mutex m_taskLock;
 		std::condition_variable m_taskSignal;
+		std::atomic<bool> m_sleeping{false};
+
+		// front tasks are always executed before any of the regular ones, the
+		// newest front task first, as with push_front on a single list
+		TaskQueue m_frontQueue, m_taskQueue;
+		// addTask calls between announcing a push and finishing it, shutdown
+		// waits for them so that its final flush sees every accepted task
+		std::atomic<uint32_t> m_pushing{0};
+		// batches taken off the queues, owned by the dispatcher thread
+		Task* m_frontBatch = NULL;
+		Task* m_taskBatch = NULL;
 
-		std::list<Task*> m_taskList;
+		DispatcherStats m_stats;
 };
 extern Dispatcher g_dispatcher;
 #endif
@@ -54,6 +54,9 @@
 #include "vocation.h"
 #include "group.h"
 #include "textlogger.h"
+#include "taskprofiler.h"
+#include "pathfinding.h"
+#include "cryptopool.h"
 #include "scheduler.h"
 
 extern ConfigManager g_config;
@@ -67,7 +70,8 @@ extern MoveEvents* g_moveEvents;
 extern CreatureEvents* g_creatureEvents;
 extern GlobalEvents* g_globalEvents;
 
-Game::Game()
+Game::Game():
+	decayWheel(EVENT_DECAYINTERVAL)
 {
 	gameState = GAMESTATE_NORMAL;
 	worldType = WORLDTYPE_OPEN;
@@ -82,7 +86,7 @@ Game::Game()
 	lightLevel = LIGHT_LEVEL_DAY;
 	lightState = LIGHT_STATE_DAY;
 
-	lastBucket = checkCreatureLastIndex = checkLightEvent = checkCreatureEvent = checkDecayEvent = saveEvent = 0;
+	checkCreatureLastIndex = checkLightEvent = checkCreatureEvent = checkDecayEvent = saveEvent = 0;
 #ifdef __WAR_SYSTEM__
 	checkWarsEvent = 0;
 #endif
@@ -95,16 +99,19 @@ Game::~Game()
 
 void Game::start(ServiceManager* servicer)
 {
-	checkDecayEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL,
+	checkDecayEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::start", EVENT_DECAYINTERVAL,
 		std::bind(&Game::checkDecay, this)));
-	checkCreatureEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_CREATURE_THINK_INTERVAL,
+	checkCreatureEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::start", EVENT_CREATURE_THINK_INTERVAL,
 		std::bind(&Game::checkCreatures, this)));
-	checkLightEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_LIGHTINTERVAL,
+	checkLightEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::start", EVENT_LIGHTINTERVAL,
 		std::bind(&Game::checkLight, this)));
 #ifdef __WAR_SYSTEM__
-	checkWarsEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_WARSINTERVAL,
+	checkWarsEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::start", EVENT_WARSINTERVAL,
 		std::bind(&Game::checkWars, this)));
 #endif
+	TaskProfiler::getInstance()->startLogging();
+	g_pathfinding.start(g_config.getNumber(ConfigManager::PATHFINDING_THREADS));
+	g_cryptoPool.start(g_config.getNumber(ConfigManager::RSA_THREADS), g_config.getNumber(ConfigManager::RSA_QUEUE_SIZE));
 
 	services = servicer;
 	if(!g_config.getBool(ConfigManager::GLOBALSAVE_ENABLED) || g_config.getNumber(ConfigManager::GLOBALSAVE_H) < 1 ||
@@ -165,7 +172,7 @@ void Game::start(ServiceManager* servicer)
 		return;
 
 	uint32_t timeLeft = (hoursLeft * 3600000) + minutesLeft * 60000;
-	saveEvent = g_scheduler.addEvent(createSchedulerTask(timeLeft,
+	saveEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::start", timeLeft,
 		std::bind(&Game::prepareGlobalSave, this)));
 }
 
@@ -219,7 +226,7 @@ void Game::setGameState(GameState_t newState)
 
 				Houses::getInstance()->payHouses();
 				saveGameState(false);
-				g_dispatcher.addTask(createTask(std::bind(&Game::shutdown, this)));
+				g_dispatcher.addTask(createTaskWithOrigin("Game::setGameState", std::bind(&Game::shutdown, this)));
 
 				g_scheduler.stop();
 				g_dispatcher.stop();
@@ -293,6 +300,40 @@ int32_t Game::loadMap(std::string filename)
 	return map->loadMap(file);
 }
 
+static void logCleanMap(uint64_t start, uint32_t count, uint32_t tiles, int32_t marked)
+{
+	std::clog << "> CLEAN: Removed " << count << " item" << (count != 1 ? "s" : "")
+		<< " from " << tiles << " tile" << (tiles != 1 ? "s" : "");
+	if(marked >= 0)
+		std::clog << " (" << marked << " were marked)";
+
+	std::clog << " in " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
+}
+
+bool Game::cleanTile(Tile* tile, bool cleanProtected, uint32_t& count)
+{
+	if(tile->hasFlag(cleanProtected ? TILESTATE_HOUSE : TILESTATE_PROTECTIONZONE) || !tile->getItemList())
+		return false;
+
+	ItemVector::iterator tit = tile->getItemList()->begin();
+	while(tile->getItemList() && tit != tile->getItemList()->end())
+	{
+		if((*tit)->isMovable() && !(*tit)->isLoadedFromMap()
+			&& !(*tit)->isScriptProtected())
+		{
+			internalRemoveItem(NULL, *tit);
+			if(tile->getItemList())
+				tit = tile->getItemList()->begin();
+
+			++count;
+		}
+		else
+			++tit;
+	}
+
+	return true;
+}
+
 void Game::cleanMapEx(uint32_t& count)
 {
 	uint64_t start = OTSYS_TIME();
@@ -303,152 +344,100 @@ void Game::cleanMapEx(uint32_t& count)
 		setGameState(GAMESTATE_MAINTAIN);
 
 	Tile* tile = NULL;
-	ItemVector::iterator tit;
+	bool cleanProtected = g_config.getBool(ConfigManager::CLEAN_PROTECTED_ZONES);
 	if(g_config.getBool(ConfigManager::STORE_TRASH))
 	{
 		marked = trash.size();
-		Trash::iterator it = trash.begin();
-		if(g_config.getBool(ConfigManager::CLEAN_PROTECTED_ZONES))
+		for(Trash::iterator it = trash.begin(); it != trash.end(); ++it)
 		{
-			for(; it != trash.end(); ++it)
-			{
-				if(!(tile = getTile(*it)))
-					continue;
-
-				tile->resetFlag(TILESTATE_TRASHED);
-				if(tile->hasFlag(TILESTATE_HOUSE) || !tile->getItemList())
-					continue;
-
-				++tiles;
-				tit = tile->getItemList()->begin();
-				while(tile->getItemList() && tit != tile->getItemList()->end())
-				{
-					if((*tit)->isMovable() && !(*tit)->isLoadedFromMap()
-						&& !(*tit)->isScriptProtected())
-					{
-						internalRemoveItem(NULL, *tit);
-						if(tile->getItemList())
-							tit = tile->getItemList()->begin();
-
-						++count;
-					}
-					else
-						++tit;
-				}
-			}
-
-			trash.clear();
-		}
-		else
-		{
-			for(; it != trash.end(); ++it)
-			{
-				if(!(tile = getTile(*it)))
-					continue;
-
-				tile->resetFlag(TILESTATE_TRASHED);
-				if(tile->hasFlag(TILESTATE_PROTECTIONZONE) || !tile->getItemList())
-					continue;
+			if(!(tile = getTile(*it)))
+				continue;
 
+			tile->resetFlag(TILESTATE_TRASHED);
+			if(cleanTile(tile, cleanProtected, count))
 				++tiles;
-				tit = tile->getItemList()->begin();
-				while(tile->getItemList() && tit != tile->getItemList()->end())
-				{
-					if((*tit)->isMovable() && !(*tit)->isLoadedFromMap()
-						&& !(*tit)->isScriptProtected())
-					{
-						internalRemoveItem(NULL, *tit);
-						if(tile->getItemList())
-							tit = tile->getItemList()->begin();
-
-						++count;
-					}
-					else
-						++tit;
-				}
-			}
-
-			trash.clear();
 		}
-	}
-	else if(g_config.getBool(ConfigManager::CLEAN_PROTECTED_ZONES))
-	{
-		for(uint16_t z = 0; z < (uint16_t)MAP_MAX_LAYERS; z++)
-		{
-			for(uint16_t y = 1; y <= map->mapHeight; y++)
-			{
-				for(uint16_t x = 1; x <= map->mapWidth; x++)
-				{
-					if(!(tile = getTile(x, y, z)) || tile->hasFlag(TILESTATE_HOUSE) || !tile->getItemList())
-						continue;
-
-					++tiles;
-					tit = tile->getItemList()->begin();
-					while(tile->getItemList() && tit != tile->getItemList()->end())
-					{
-						if((*tit)->isMovable() && !(*tit)->isLoadedFromMap()
-							&& !(*tit)->isScriptProtected())
-						{
-							internalRemoveItem(NULL, *tit);
-							if(tile->getItemList())
-								tit = tile->getItemList()->begin();
 
-							++count;
-						}
-						else
-							++tit;
-					}
-				}
-			}
-		}
+		trash.clear();
 	}
 	else
 	{
-		for(uint16_t z = 0; z < (uint16_t)MAP_MAX_LAYERS; z++)
+		//cleaning a tile drops it from the index, so look the next one up again
+		Position pos;
+		for(DirtyTiles::iterator it = dirtyTiles.begin(); it != dirtyTiles.end(); it = dirtyTiles.upper_bound(pos))
 		{
-			for(uint16_t y = 1; y <= map->mapHeight; y++)
-			{
-				for(uint16_t x = 1; x <= map->mapWidth; x++)
-				{
-					if(!(tile = getTile(x, y, z)) || tile->hasFlag(TILESTATE_PROTECTIONZONE) || !tile->getItemList())
-						continue;
-
-					++tiles;
-					tit = tile->getItemList()->begin();
-					while(tile->getItemList() && tit != tile->getItemList()->end())
-					{
-						if((*tit)->isMovable() && !(*tit)->isLoadedFromMap()
-							&& !(*tit)->isScriptProtected())
-						{
-							internalRemoveItem(NULL, *tit);
-							if(tile->getItemList())
-								tit = tile->getItemList()->begin();
-
-							++count;
-						}
-						else
-							++tit;
-					}
-				}
-			}
+			pos = *it;
+			if((tile = getTile(pos)))
+				cleanTile(tile, cleanProtected, count);
 		}
+
+		tiles = getCleanMapTileCount(cleanProtected);
 	}
 
 	if(gameState == GAMESTATE_MAINTAIN)
 		setGameState(GAMESTATE_NORMAL);
 
-	std::clog << "> CLEAN: Removed " << count << " item" << (count != 1 ? "s" : "")
-		<< " from " << tiles << " tile" << (tiles != 1 ? "s" : "");
-	if(marked >= 0)
-		std::clog << " (" << marked << " were marked)";
+	logCleanMap(start, count, tiles, marked);
+}
 
-	std::clog << " in " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
+bool Game::cleanMap(bool reopen/* = false*/)
+{
+	int32_t slice = g_config.getNumber(ConfigManager::CLEAN_MAP_SLICE);
+	if(slice <= 0 || g_config.getBool(ConfigManager::STORE_TRASH))
+	{
+		uint32_t dummy;
+		cleanMapEx(dummy);
+		return false;
+	}
+
+	if(cleanMapState.running)
+	{
+		cleanMapState.reopen = cleanMapState.reopen || reopen;
+		return true;
+	}
+
+	cleanMapState = CleanMapState();
+	cleanMapState.running = true;
+	cleanMapState.reopen = reopen;
+	cleanMapState.slice = slice;
+	cleanMapState.start = OTSYS_TIME();
+	cleanMapSlice();
+	return cleanMapState.running;
 }
 
-void Game::cleanMap()
+uint32_t Game::getCleanMapTileCount(bool cleanProtected) const
 {
-	uint32_t dummy;
-	cleanMapEx(dummy);
+	//the full map walk this replaced counted every tile with an item list
+	return cleanProtected ? Floor::itemTilesOutsideHouses : Floor::itemTilesOutsidePz;
+}
+
+void Game::cleanMapSlice()
+{
+	DirtyTiles::iterator it = dirtyTiles.begin();
+	if(cleanMapState.started)
+		it = dirtyTiles.upper_bound(cleanMapState.pos);
+
+	Tile* tile = NULL;
+	bool cleanProtected = g_config.getBool(ConfigManager::CLEAN_PROTECTED_ZONES);
+	for(uint32_t i = 0; i < cleanMapState.slice && it != dirtyTiles.end(); ++i, it = dirtyTiles.upper_bound(cleanMapState.pos))
+	{
+		cleanMapState.pos = *it;
+		cleanMapState.started = true;
+		if((tile = getTile(cleanMapState.pos)))
+			cleanTile(tile, cleanProtected, cleanMapState.count);
+	}
+
+	if(it != dirtyTiles.end())
+	{
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::cleanMapSlice", EVENT_CLEANMAPINTERVAL,
+			std::bind(&Game::cleanMapSlice, this)));
+		return;
+	}
+
+	cleanMapState.running = false;
+	logCleanMap(cleanMapState.start, cleanMapState.count, getCleanMapTileCount(cleanProtected), -1);
+	if(cleanMapState.reopen)
+		setGameState(GAMESTATE_NORMAL);
 }
 
 void Game::proceduralRefresh(RefreshTiles::iterator* it/* = NULL*/)
@@ -466,7 +455,7 @@ void Game::proceduralRefresh(RefreshTiles::iterator* it/* = NULL*/)
 
 	// Refresh some items every 100 ms until all tiles has been checked
 	// For 100k tiles, this would take 100000/2500 = 40s = half a minute
-	g_scheduler.addEvent(createSchedulerTask(100,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::proceduralRefresh", 100,
 		std::bind(&Game::proceduralRefresh, this, it)));
 }
 
@@ -1058,7 +1047,7 @@ bool Game::playerMoveCreature(uint32_t playerId, uint32_t movingCreatureId,
 	if(!player->canDoAction())
 	{
 		uint32_t delay = player->getNextActionTime();
-		SchedulerTask* task = createSchedulerTask(delay, std::bind(&Game::playerMoveCreature,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveCreature", delay, std::bind(&Game::playerMoveCreature,
 			this, playerId, movingCreatureId, movingCreaturePos, toPos, true));
 
 		player->setNextActionTask(task);
@@ -1076,9 +1065,9 @@ bool Game::playerMoveCreature(uint32_t playerId, uint32_t movingCreatureId,
 		std::list<Direction> listDir;
 		if(getPathToEx(player, movingCreaturePos, listDir, 0, 1, true, true))
 		{
-			g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+			g_dispatcher.addTask(createTaskWithOrigin("Game::playerMoveCreature", std::bind(&Game::playerAutoWalk,
 				this, player->getID(), listDir)));
-			SchedulerTask* task = createSchedulerTask(std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveCreature", std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
 				std::bind(&Game::playerMoveCreature, this, playerId, movingCreatureId, movingCreaturePos, toPos, true));
 
 			player->setNextWalkActionTask(task);
@@ -1093,7 +1082,7 @@ bool Game::playerMoveCreature(uint32_t playerId, uint32_t movingCreatureId,
 		uint32_t delayTime = g_config.getNumber(ConfigManager::PUSH_CREATURE_DELAY);
 		if(delayTime > 0)
 		{
-			SchedulerTask* task = createSchedulerTask(delayTime,
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveCreature", delayTime,
 				std::bind(&Game::playerMoveCreature, this, playerId, movingCreatureId, movingCreaturePos, toPos, false));
 			player->setNextActionTask(task);
 			return true;
@@ -1306,7 +1295,7 @@ bool Game::playerMoveItem(uint32_t playerId, const Position& fromPos,
 	if(!player->canDoAction())
 	{
 		uint32_t delay = player->getNextActionTime();
-		SchedulerTask* task = createSchedulerTask(delay, std::bind(&Game::playerMoveItem, this,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveItem", delay, std::bind(&Game::playerMoveItem, this,
 			playerId, fromPos, spriteId, fromStackpos, toPos, count));
 
 		player->setNextActionTask(task);
@@ -1379,9 +1368,9 @@ bool Game::playerMoveItem(uint32_t playerId, const Position& fromPos,
 		std::list<Direction> listDir;
 		if(getPathToEx(player, item->getPosition(), listDir, 0, 1, true, true))
 		{
-			g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+			g_dispatcher.addTask(createTaskWithOrigin("Game::playerMoveItem", std::bind(&Game::playerAutoWalk,
 				this, player->getID(), listDir)));
-			SchedulerTask* task = createSchedulerTask(std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveItem", std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
 				std::bind(&Game::playerMoveItem, this, playerId, fromPos, spriteId, fromStackpos, toPos, count));
 
 			player->setNextWalkActionTask(task);
@@ -1443,9 +1432,9 @@ bool Game::playerMoveItem(uint32_t playerId, const Position& fromPos,
 			std::list<Direction> listDir;
 			if(map->getPathTo(player, walkPos, listDir))
 			{
-				g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+				g_dispatcher.addTask(createTaskWithOrigin("Game::playerMoveItem", std::bind(&Game::playerAutoWalk,
 					this, player->getID(), listDir)));
-				SchedulerTask* task = createSchedulerTask(std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
+				SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerMoveItem", std::max((int32_t)SCHEDULER_MINTICKS, player->getStepDuration()),
 					std::bind(&Game::playerMoveItem, this, playerId, itemPos, spriteId, itemStackpos, toPos, count));
 
 				player->setNextWalkActionTask(task);
@@ -2588,10 +2577,10 @@ bool Game::playerUseItemEx(uint32_t playerId, const Position& fromPos, int16_t f
 			std::list<Direction> listDir;
 			if(getPathToEx(player, walkToPos, listDir, 0, 1, true, true, 10))
 			{
-				g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+				g_dispatcher.addTask(createTaskWithOrigin("Game::playerUseItemEx", std::bind(&Game::playerAutoWalk,
 					this, player->getID(), listDir)));
 
-				SchedulerTask* task = createSchedulerTask(400, std::bind(&Game::playerUseItemEx, this,
+				SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseItemEx", 400, std::bind(&Game::playerUseItemEx, this,
 					playerId, itemPos, itemStackpos, fromSpriteId, toPos, toStackpos, toSpriteId, isHotkey));
 
 				player->setNextWalkActionTask(task);
@@ -2611,7 +2600,7 @@ bool Game::playerUseItemEx(uint32_t playerId, const Position& fromPos, int16_t f
 	if(!player->canDoAction())
 	{
 		uint32_t delay = player->getNextActionTime();
-		SchedulerTask* task = createSchedulerTask(delay, std::bind(&Game::playerUseItemEx, this,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseItemEx", delay, std::bind(&Game::playerUseItemEx, this,
 			playerId, fromPos, fromStackpos, fromSpriteId, toPos, toStackpos, toSpriteId, isHotkey));
 
 		player->setNextActionTask(task);
@@ -2654,10 +2643,10 @@ bool Game::playerUseItem(uint32_t playerId, const Position& pos, int16_t stackpo
 			std::list<Direction> listDir;
 			if(getPathToEx(player, pos, listDir, 0, 1, true, true))
 			{
-				g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+				g_dispatcher.addTask(createTaskWithOrigin("Game::playerUseItem", std::bind(&Game::playerAutoWalk,
 					this, player->getID(), listDir)));
 
-				SchedulerTask* task = createSchedulerTask(400, std::bind(&Game::playerUseItem, this,
+				SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseItem", 400, std::bind(&Game::playerUseItem, this,
 					playerId, pos, stackpos, index, spriteId, isHotkey));
 
 				player->setNextWalkActionTask(task);
@@ -2677,7 +2666,7 @@ bool Game::playerUseItem(uint32_t playerId, const Position& pos, int16_t stackpo
 	if(!player->canDoAction())
 	{
 		uint32_t delay = player->getNextActionTime();
-		SchedulerTask* task = createSchedulerTask(delay, std::bind(&Game::playerUseItem, this,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseItem", delay, std::bind(&Game::playerUseItem, this,
 			playerId, pos, stackpos, index, spriteId, isHotkey));
 
 		player->setNextActionTask(task);
@@ -2730,10 +2719,10 @@ bool Game::playerUseBattleWindow(uint32_t playerId, const Position& fromPos, int
 			std::list<Direction> listDir;
 			if(getPathToEx(player, item->getPosition(), listDir, 0, 1, true, true))
 			{
-				g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+				g_dispatcher.addTask(createTaskWithOrigin("Game::playerUseBattleWindow", std::bind(&Game::playerAutoWalk,
 					this, player->getID(), listDir)));
 
-				SchedulerTask* task = createSchedulerTask(400, std::bind(&Game::playerUseBattleWindow, this,
+				SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseBattleWindow", 400, std::bind(&Game::playerUseBattleWindow, this,
 					playerId, fromPos, fromStackpos, creatureId, spriteId, isHotkey));
 
 				player->setNextWalkActionTask(task);
@@ -2753,7 +2742,7 @@ bool Game::playerUseBattleWindow(uint32_t playerId, const Position& fromPos, int
 	if(!player->canDoAction())
 	{
 		uint32_t delay = player->getNextActionTime();
-		SchedulerTask* task = createSchedulerTask(delay, std::bind(&Game::playerUseBattleWindow, this,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerUseBattleWindow", delay, std::bind(&Game::playerUseBattleWindow, this,
 			playerId, fromPos, fromStackpos, creatureId, spriteId, isHotkey));
 
 		player->setNextActionTask(task);
@@ -2847,10 +2836,10 @@ bool Game::playerRotateItem(uint32_t playerId, const Position& pos, int16_t stac
 		std::list<Direction> listDir;
 		if(getPathToEx(player, pos, listDir, 0, 1, true, true))
 		{
-			g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+			g_dispatcher.addTask(createTaskWithOrigin("Game::playerRotateItem", std::bind(&Game::playerAutoWalk,
 				this, player->getID(), listDir)));
 
-			SchedulerTask* task = createSchedulerTask(400, std::bind(&Game::playerRotateItem, this,
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerRotateItem", 400, std::bind(&Game::playerRotateItem, this,
 				playerId, pos, stackpos, spriteId));
 
 			player->setNextWalkActionTask(task);
@@ -3009,10 +2998,10 @@ bool Game::playerRequestTrade(uint32_t playerId, const Position& pos, int16_t st
 		std::list<Direction> listDir;
 		if(getPathToEx(player, pos, listDir, 0, 1, true, true))
 		{
-			g_dispatcher.addTask(createTask(std::bind(&Game::playerAutoWalk,
+			g_dispatcher.addTask(createTaskWithOrigin("Game::playerRequestTrade", std::bind(&Game::playerAutoWalk,
 				this, player->getID(), listDir)));
 
-			SchedulerTask* task = createSchedulerTask(400, std::bind(&Game::playerRequestTrade, this,
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Game::playerRequestTrade", 400, std::bind(&Game::playerRequestTrade, this,
 				playerId, pos, stackpos, tradePlayerId, spriteId));
 
 			player->setNextWalkActionTask(task);
@@ -3663,7 +3652,7 @@ bool Game::playerSetAttackedCreature(uint32_t playerId, uint32_t creatureId)
     }
 
 	player->setAttackedCreature(attackCreature);
-	g_dispatcher.addTask(createTask(std::bind(
+	g_dispatcher.addTask(createTaskWithOrigin("Game::playerSetAttackedCreature", std::bind(
 		&Game::updateCreatureWalk, this, player->getID())));
 	return true;
 }
@@ -3679,7 +3668,7 @@ bool Game::playerFollowCreature(uint32_t playerId, uint32_t creatureId)
 		followCreature = getCreatureByID(creatureId);
 
 	player->setAttackedCreature(NULL);
-	g_dispatcher.addTask(createTask(std::bind(
+	g_dispatcher.addTask(createTaskWithOrigin("Game::playerFollowCreature", std::bind(
 		&Game::updateCreatureWalk, this, player->getID())));
 	return player->setFollowCreature(followCreature);
 }
@@ -4187,6 +4176,7 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 		list = (*spectators);
 
 	//send to client
+	NetworkMessage_ptr packet = ProtocolGame::createCreatureSay(creature, type, text, &destPos);
 	Player* tmpPlayer = NULL;
 	for(it = list.begin(); it != list.end(); ++it)
 	{
@@ -4194,7 +4184,7 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 			continue;
 
 		if(!ghostMode || tmpPlayer->canSeeCreature(creature))
-			tmpPlayer->sendCreatureSay(creature, type, text, &destPos);
+			tmpPlayer->sendCreatureSay(creature, packet);
 	}
 
 	//event method
@@ -4205,9 +4195,9 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 }
 
 bool Game::getPathTo(const Creature* creature, const Position& destPos,
-	std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/)
+	std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/, uint32_t maxNodes /*= MAX_NODES*/)
 {
-	return map->getPathTo(creature, destPos, listDir, maxSearchDist);
+	return map->getPathTo(creature, destPos, listDir, maxSearchDist, maxNodes);
 }
 
 bool Game::getPathToEx(const Creature* creature, const Position& targetPos,
@@ -4244,7 +4234,7 @@ bool Game::steerCreature(Creature* creature, const Position& position)
 
 	if(!Position::areInRange<1,1,0>(creature->getPosition(), position))
 	{
-		SchedulerTask* task = createSchedulerTask(std::max((int32_t)SCHEDULER_MINTICKS,
+		SchedulerTask* task = createSchedulerTaskWithOrigin("Game::steerCreature", std::max((int32_t)SCHEDULER_MINTICKS,
 			creature->getStepDuration()), std::bind(&Game::steerCreature, this, creature, position));
 
 		if(Player* player = creature->getPlayer())
@@ -4284,26 +4274,40 @@ void Game::addCreatureCheck(Creature* creature)
 	if(creature->isRemoved())
 		return;
 
+	if(creature->checkVector == -1 && !creature->getPlayer() && !map->isRegionActive(creature))
+	{
+		//nobody around, Map::updateRegionActivation adds it once a player comes close
+		creature->suspended = true;
+		return;
+	}
+
 	creature->checked = true;
+	creature->suspended = false;
 	if(creature->checkVector >= 0) //already in a vector, or about to be added
 		return;
 
 	toAddCheckCreatureVector.push_back(creature);
 	creature->checkVector = random_range(0, EVENT_CREATURECOUNT - 1);
+	creature->thinkTier = THINKTIER_FULL;
+	creature->thinkTicks = 0;
 	creature->addRef();
 }
 
 void Game::removeCreatureCheck(Creature* creature)
 {
+	creature->suspended = false;
 	if(creature->checkVector == -1) //not in any vector
 		return;
 
 	creature->checked = false;
 }
 
+//think intervals between two thinks of a creature in each tier
+static const uint32_t thinkTierPeriods[THINKTIER_LAST] = {1, 2, 4};
+
 void Game::checkCreatures()
 {
-	checkCreatureEvent = g_scheduler.addEvent(createSchedulerTask(
+	checkCreatureEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::checkCreatures",
 		EVENT_CHECK_CREATURE_INTERVAL, std::bind(&Game::checkCreatures, this)));
 	checkCreatureLastIndex++;
 	if(checkCreatureLastIndex == EVENT_CREATURECOUNT)
@@ -4317,10 +4321,34 @@ void Game::checkCreatures()
 	std::vector<Creature*>& checkCreatureVector = checkCreatureVectors[checkCreatureLastIndex];
 	for(it = checkCreatureVector.begin(); it != checkCreatureVector.end();)
 	{
+		if((*it)->checked && !(*it)->getPlayer() && !map->isRegionActive(*it))
+		{
+			//the last player left the region, drop it until one comes back
+			(*it)->checked = false;
+			(*it)->suspended = true;
+			++map->regionStats.suspended;
+		}
+
 		if((*it)->checked)
 		{
-			if((*it)->getHealth() > 0 || !(*it)->onDeath())
-				(*it)->onThink(EVENT_CREATURE_THINK_INTERVAL);
+			//every creature keeps its slot, the slower tiers just let visits pass
+			(*it)->thinkTicks += EVENT_CREATURE_THINK_INTERVAL;
+			if((*it)->hasThinkPriority())
+				(*it)->thinkTier = THINKTIER_FULL;
+
+			if((*it)->thinkTicks >= thinkTierPeriods[(*it)->thinkTier] * EVENT_CREATURE_THINK_INTERVAL)
+			{
+				uint32_t interval = (*it)->thinkTicks;
+				(*it)->thinkTicks = 0;
+				++thinkStats.thinks[(*it)->thinkTier];
+				if((*it)->getHealth() > 0 || !(*it)->onDeath())
+					(*it)->onThink(interval);
+
+				if(!(*it)->isRemoved())
+					(*it)->thinkTier = getThinkTier(*it);
+			}
+			else
+				++thinkStats.skipped;
 
 			++it;
 		}
@@ -4335,13 +4363,32 @@ void Game::checkCreatures()
 	cleanup();
 }
 
+ThinkTier_t Game::getThinkTier(const Creature* creature)
+{
+	if(creature->getPlayer() || creature->hasThinkPriority())
+		return THINKTIER_FULL;
+
+	const Position& pos = creature->getPosition();
+	const SpectatorVec& list = getPlayerSpectators(pos);
+	if(list.empty())
+		return THINKTIER_FAR;
+
+	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
+	{
+		if(Creature::canSee((*it)->getPosition(), pos, Map::maxClientViewportX, Map::maxClientViewportY))
+			return THINKTIER_FULL;
+	}
+
+	return THINKTIER_EDGE;
+}
+
 void Game::changeSpeed(Creature* creature, int32_t varSpeedDelta)
 {
 	int32_t varSpeed = creature->getSpeed() - creature->getBaseSpeed();
 	varSpeed += varSpeedDelta;
 	creature->setSpeed(varSpeed);
 
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 	SpectatorVec::const_iterator it;
 
 	//send to client
@@ -4407,7 +4454,7 @@ void Game::internalCreatureChangeVisible(Creature* creature, Visible_t visible)
 
 void Game::changeLight(const Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -4766,7 +4813,7 @@ bool Game::combatChangeMana(Creature* attacker, Creature* target, int32_t manaCh
 
 void Game::addCreatureHealth(const Creature* target)
 {
-	const SpectatorVec& list = getSpectators(target->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(target->getPosition());
 	addCreatureHealth(list, target);
 }
 
@@ -4782,7 +4829,7 @@ void Game::addCreatureHealth(const SpectatorVec& list, const Creature* target)
 
 void Game::addCreatureSquare(const Creature* target, uint8_t squareColor)
 {
-	const SpectatorVec& list = getSpectators(target->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(target->getPosition());
 	addCreatureSquare(list, target, squareColor);
 }
 
@@ -4798,18 +4845,19 @@ void Game::addCreatureSquare(const SpectatorVec& list, const Creature* target, u
 
 void Game::addAnimatedText(const Position& pos, uint8_t textColor, const std::string& text)
 {
-	const SpectatorVec& list = getSpectators(pos);
+	const SpectatorVec& list = getPlayerSpectators(pos);
 	addAnimatedText(list, pos, textColor, text);
 }
 
 void Game::addAnimatedText(const SpectatorVec& list, const Position& pos, uint8_t textColor,
 	const std::string& text)
 {
+	NetworkMessage_ptr packet = ProtocolGame::createAnimatedText(pos, textColor, text);
 	Player* player = NULL;
 	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
-		if((player = (*it)->getPlayer()))
-			player->sendAnimatedText(pos, textColor, text);
+		if((player = (*it)->getPlayer()) && player->canSee(pos))
+			player->sendPacket(packet);
 	}
 }
 
@@ -4818,58 +4866,135 @@ void Game::addMagicEffect(const Position& pos, uint16_t effect, bool ghostMode/*
 	if(ghostMode)
 		return;
 
-	const SpectatorVec& list = getSpectators(pos);
+	const SpectatorVec& list = getPlayerSpectators(pos);
 	addMagicEffect(list, pos, effect);
 }
 
 void Game::addMagicEffect(const SpectatorVec& list, const Position& pos, uint16_t effect,
 	bool ghostMode/* = false*/)
 {
-	if(ghostMode)
+	if(ghostMode || effect > MAGIC_EFFECT_LAST)
 		return;
 
+	NetworkMessage_ptr packet = ProtocolGame::createMagicEffect(pos, effect);
 	Player* player = NULL;
 	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
-		if((player = (*it)->getPlayer()))
-			player->sendMagicEffect(pos, effect);
+		if((player = (*it)->getPlayer()) && player->canSee(pos))
+			player->sendPacket(packet);
 	}
 }
 
 void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, uint16_t effect)
 {
 	SpectatorVec list;
-	getSpectators(list, fromPos, false);
-	getSpectators(list, toPos, true);
+	getPlayerSpectators(list, fromPos);
+	getPlayerSpectators(list, toPos);
 	addDistanceEffect(list, fromPos, toPos, effect);
 }
 
 void Game::addDistanceEffect(const SpectatorVec& list, const Position& fromPos,
 	const Position& toPos, uint16_t effect)
 {
+	if(effect > SHOOT_EFFECT_LAST)
+		return;
+
+	NetworkMessage_ptr packet = ProtocolGame::createDistanceShoot(fromPos, toPos, effect);
 	Player* player = NULL;
 	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
-		if((player = (*it)->getPlayer()))
-			player->sendDistanceShoot(fromPos, toPos, effect);
+		if((player = (*it)->getPlayer()) && (player->canSee(fromPos) || player->canSee(toPos)))
+			player->sendPacket(packet);
 	}
 }
 
 void Game::startDecay(Item* item)
 {
-	if(!item || !item->canDecay() || item->getDecaying() == DECAYING_TRUE)
+	if(!item || !item->canDecay() || item->getDecaying() == DECAYING_TRUE
+		|| item->getDecaying() == DECAYING_PAUSED)
 		return;
 
 	if(item->getDuration() > 0)
 	{
-		item->addRef();
 		item->setDecaying(DECAYING_TRUE);
-		toDecayItems.push_back(item);
+		scheduleDecay(item);
 	}
 	else
 		internalDecayItem(item);
 }
 
+void Game::scheduleDecay(Item* item)
+{
+	item->addRef();
+	item->setDecayExpiry(OTSYS_TIME() + item->getDuration());
+	decayWheel.add(item, item->getDecayExpiry());
+}
+
+void Game::pauseDecay(Item* item)
+{
+	ItemDecayState_t state = item->getDecaying();
+	if(state == DECAYING_TRUE || state == DECAYING_PENDING)
+	{
+		item->resetDecayExpiry();
+		item->setDecaying(DECAYING_PAUSED);
+	}
+
+	if(Container* container = item->getContainer())
+	{
+		for(ItemList::const_iterator it = container->getItems(); it != container->getEnd(); ++it)
+			pauseDecay(*it);
+	}
+}
+
+void Game::resumeDecay(Item* item)
+{
+	if(item->getDecaying() == DECAYING_PAUSED)
+	{
+		item->setDecaying(DECAYING_PENDING);
+		startDecay(item);
+	}
+
+	if(Container* container = item->getContainer())
+	{
+		for(ItemList::const_iterator it = container->getItems(); it != container->getEnd(); ++it)
+			resumeDecay(*it);
+	}
+}
+
+void Game::updateStoredDecay(Item* item)
+{
+	if(isStoredItem(item))
+		pauseDecay(item);
+	else
+		resumeDecay(item);
+}
+
+bool Game::isStoredItem(const Item* item) const
+{
+	const Item* topItem = item;
+	for(const Cylinder* parent = item->getParent(); parent; parent = parent->getParent())
+	{
+		if(parent->getCreature())
+			return false;
+
+		if(const Item* parentItem = parent->getItem())
+		{
+			const Container* container = parentItem->getContainer();
+			if(container && container->getDepot())
+				return true;
+
+			topItem = parentItem;
+		}
+		else if(const Tile* tile = parent->getTile())
+		{
+			//fields and other fixtures lying in a house keep decaying
+			return tile->isHouseTile() && (topItem != item || item->isMovable());
+		}
+	}
+
+	return false;
+}
+
 void Game::internalDecayItem(Item* item)
 {
 	const ItemType& it = Item::items.getItemType(item->getID());
@@ -4888,56 +5013,57 @@ void Game::internalDecayItem(Item* item)
 
 void Game::checkDecay()
 {
-	checkDecayEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL,
+	checkDecayEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::checkDecay", EVENT_DECAYINTERVAL,
 		std::bind(&Game::checkDecay, this)));
 
-	size_t bucket = (lastBucket + 1) % EVENT_DECAYBUCKETS;
-	for(DecayList::iterator it = decayItems[bucket].begin(); it != decayItems[bucket].end();)
-	{
-		Item* item = *it;
-		int32_t decreaseTime = EVENT_DECAYINTERVAL * EVENT_DECAYBUCKETS;
-		if(item->getDuration() - decreaseTime < 0)
-			decreaseTime = item->getDuration();
+	int64_t now = OTSYS_TIME();
+	DecayEntryList list;
+	decayWheel.advance(now, list);
 
-		item->decreaseDuration(decreaseTime);
-		if(!item->canDecay())
+	DecayStats& stats = decayWheel.getStats();
+	for(DecayEntryList::iterator it = list.begin(); it != list.end(); ++it)
+	{
+		Item* item = it->item;
+		if(item->getDecayExpiry() != it->expiry)
 		{
-			item->setDecaying(DECAYING_FALSE);
+			//paused, transformed or given a new duration since
+			++stats.stale;
 			freeThing(item);
-			it = decayItems[bucket].erase(it);
 			continue;
 		}
 
-		int32_t dur = item->getDuration();
-		if(dur <= 0)
+		if(item->getDecaying() != DECAYING_TRUE || !item->canDecay())
 		{
-			it = decayItems[bucket].erase(it);
-			internalDecayItem(item);
+			item->resetDecayExpiry();
+			if(item->getDecaying() == DECAYING_TRUE)
+				item->setDecaying(DECAYING_FALSE);
+
+			++stats.stale;
 			freeThing(item);
+			continue;
 		}
-		else if(dur < EVENT_DECAYINTERVAL * EVENT_DECAYBUCKETS)
+
+		if(it->expiry > now)
 		{
-			it = decayItems[bucket].erase(it);
-			size_t newBucket = (bucket + ((dur + EVENT_DECAYINTERVAL / 2) / 1000)) % EVENT_DECAYBUCKETS;
-			if(newBucket == bucket)
-			{
-				internalDecayItem(item);
-				freeThing(item);
-			}
-			else
-				decayItems[newBucket].push_back(item);
+			//was further away than the wheel reaches
+			decayWheel.add(item, it->expiry);
+			continue;
 		}
-		else
-			++it;
+
+		++stats.expired;
+		item->setDecayExpiry(0);
+		item->setDuration(0);
+
+		internalDecayItem(item);
+		freeThing(item);
 	}
 
-	lastBucket = bucket;
 	cleanup();
 }
 
 void Game::checkLight()
 {
-	checkLightEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_LIGHTINTERVAL,
+	checkLightEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::checkLight", EVENT_LIGHTINTERVAL,
 		std::bind(&Game::checkLight, this)));
 
 	lightHour = lightHour + lightHourDelta;
@@ -4998,7 +5124,7 @@ void Game::checkLight()
 void Game::checkWars()
 {
 	IOGuild::getInstance()->checkWars();
-	checkWarsEvent = g_scheduler.addEvent(createSchedulerTask(EVENT_WARSINTERVAL,
+	checkWarsEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::checkWars", EVENT_WARSINTERVAL,
 		std::bind(&Game::checkWars, this)));
 }
 #endif
@@ -5050,7 +5176,7 @@ bool Game::closeRuleViolation(Player* player)
 
 void Game::updateCreatureSkull(Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -5063,7 +5189,7 @@ void Game::updateCreatureSkull(Creature* creature)
 
 void Game::updateCreatureShield(Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -5076,7 +5202,7 @@ void Game::updateCreatureShield(Creature* creature)
 
 void Game::updateCreatureEmblem(Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -5089,7 +5215,7 @@ void Game::updateCreatureEmblem(Creature* creature)
 
 void Game::updateCreatureImpassable(Creature* creature)
 {
-	const SpectatorVec& list = getSpectators(creature->getPosition());
+	const SpectatorVec& list = getPlayerSpectators(creature->getPosition());
 
 	//send to client
 	Player* tmpPlayer = NULL;
@@ -5550,7 +5676,7 @@ bool Game::playerViolationWindow(uint32_t playerId, std::string name, uint8_t re
 		target->sendTextMessage(MSG_INFO_DESCR, buffer);
 
 		addMagicEffect(target->getPosition(), MAGIC_EFFECT_WRAPS_GREEN);
-		g_scheduler.addEvent(createSchedulerTask(1000, std::bind(
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::playerViolationWindow", 1000, std::bind(
 			&Game::kickPlayer, this, target->getID(), false)));
 	}
 
@@ -5609,6 +5735,9 @@ Position Game::getClosestFreeTile(Creature* creature, Position pos, bool extende
 			if(!tile || !tile->ground)
 				continue;
 
+			if(tile->getPathState(player) == PATHSTATE_FREE)
+				return tile->getPosition();
+
 			ReturnValue ret = tile->__queryAdd(0, player, 1, FLAG_IGNOREBLOCKITEM);
 			if(ret == RET_NOTENOUGHROOM || (ret == RET_NOTPOSSIBLE && !player->hasCustomFlag(PlayerCustomFlag_CanMoveAnywhere))
 				|| (ret == RET_PLAYERISNOTINVITED && !ignoreHouse && !player->hasFlag(PlayerFlag_CanEditHouses)))
@@ -5623,7 +5752,7 @@ Position Game::getClosestFreeTile(Creature* creature, Position pos, bool extende
 		{
 			Tile* tile = NULL;
 			if((tile = map->getTile(Position((pos.x + it->first), (pos.y + it->second), pos.z)))
-				&& tile->__queryAdd(0, creature, 1, FLAG_IGNOREBLOCKITEM) == RET_NOERROR)
+				&& (tile->getPathState(creature) == PATHSTATE_FREE || tile->__queryAdd(0, creature, 1, FLAG_IGNOREBLOCKITEM) == RET_NOERROR))
 				return tile->getPosition();
 		}
 	}
@@ -5977,7 +6106,7 @@ void Game::checkHighscores()
 	if(tmp <= 0)
 		return;
 
-	g_scheduler.addEvent(createSchedulerTask(tmp, std::bind(&Game::checkHighscores, this)));
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::checkHighscores", tmp, std::bind(&Game::checkHighscores, this)));
 }
 
 std::string Game::getHighscoreString(uint16_t skill)
@@ -6137,7 +6266,10 @@ bool Game::reloadInfo(ReloadInfo_t reload, uint32_t playerId/* = 0*/)
 		case RELOAD_CONFIG:
 		{
 			if(g_config.reload())
+			{
+				TaskProfiler::getInstance()->startLogging();
 				done = true;
+			}
 			else
 				std::clog << "[Error - Game::reloadInfo] Failed to reload config." << std::endl;
 
@@ -6372,19 +6504,19 @@ void Game::prepareGlobalSave()
 		globalSaveMessage[0] = true;
 
 		broadcastMessage("Server is going down for a global save within 5 minutes. Please logout.", MSG_STATUS_WARNING);
-		g_scheduler.addEvent(createSchedulerTask(120000, std::bind(&Game::prepareGlobalSave, this)));
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::prepareGlobalSave", 120000, std::bind(&Game::prepareGlobalSave, this)));
 	}
 	else if(!globalSaveMessage[1])
 	{
 		globalSaveMessage[1] = true;
 		broadcastMessage("Server is going down for a global save within 3 minutes. Please logout.", MSG_STATUS_WARNING);
-		g_scheduler.addEvent(createSchedulerTask(120000, std::bind(&Game::prepareGlobalSave, this)));
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::prepareGlobalSave", 120000, std::bind(&Game::prepareGlobalSave, this)));
 	}
 	else if(!globalSaveMessage[2])
 	{
 		globalSaveMessage[2] = true;
 		broadcastMessage("Server is going down for a global save in one minute, please logout!", MSG_STATUS_WARNING);
-		g_scheduler.addEvent(createSchedulerTask(60000, std::bind(&Game::prepareGlobalSave, this)));
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::prepareGlobalSave", 60000, std::bind(&Game::prepareGlobalSave, this)));
 	}
 	else
 		globalSave();
@@ -6401,15 +6533,16 @@ void Game::globalSave()
 	if(close)
 	{
 		//shutdown server
-		g_dispatcher.addTask(createTask(std::bind(&Game::setGameState, this, GAMESTATE_SHUTDOWN)));
+		g_dispatcher.addTask(createTaskWithOrigin("Game::globalSave", std::bind(&Game::setGameState, this, GAMESTATE_SHUTDOWN)));
 		return;
 	}
 
 	//close server
-	g_dispatcher.addTask(createTask(std::bind(&Game::setGameState, this, GAMESTATE_CLOSED)));
-	//clean map if configured to
+	g_dispatcher.addTask(createTaskWithOrigin("Game::globalSave", std::bind(&Game::setGameState, this, GAMESTATE_CLOSED)));
+	//clean map if configured to, a sliced clean opens the server when it is done
+	bool cleaning = false;
 	if(g_config.getBool(ConfigManager::CLEAN_MAP_AT_GLOBALSAVE))
-		cleanMap();
+		cleaning = cleanMap(true);
 
 	//pay houses
 	Houses::getInstance()->payHouses();
@@ -6426,14 +6559,17 @@ void Game::globalSave()
 		setGlobalSaveMessage(i, false);
 
 	//prepare for next global save after 24 hours
-	g_scheduler.addEvent(createSchedulerTask(86100000, std::bind(&Game::prepareGlobalSave, this)));
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("Game::globalSave", 86100000, std::bind(&Game::prepareGlobalSave, this)));
 	//open server
-	g_dispatcher.addTask(createTask(std::bind(&Game::setGameState, this, GAMESTATE_NORMAL)));
+	if(!cleaning)
+		g_dispatcher.addTask(createTaskWithOrigin("Game::globalSave", std::bind(&Game::setGameState, this, GAMESTATE_NORMAL)));
 }
 
 void Game::shutdown()
 {
 	std::clog << "Preparing";
+	g_pathfinding.shutdown();
+	g_cryptoPool.shutdown();
 	g_scheduler.shutdown();
 	std::clog << " to";
 	g_dispatcher.shutdown();
@@ -6459,16 +6595,6 @@ void Game::cleanup()
 		(*it)->unRef();
 
 	releaseThings.clear();
-	for(DecayList::iterator it = toDecayItems.begin(); it != toDecayItems.end(); ++it)
-	{
-		int32_t dur = (*it)->getDuration();
-		if(dur >= EVENT_DECAYINTERVAL * EVENT_DECAYBUCKETS)
-			decayItems[lastBucket].push_back(*it);
-		else
-			decayItems[(lastBucket + 1 + (*it)->getDuration() / 1000) % EVENT_DECAYBUCKETS].push_back(*it);
-	}
-
-	toDecayItems.clear();
 }
 
 void Game::freeThing(Thing* thing)
@@ -29,6 +29,7 @@
 #include "npc.h"
 #include "monster.h"
 #include "templates.h"
+#include "decay.h"
 
 class Creature;
 class Player;
@@ -129,11 +130,31 @@ typedef std::map<uint32_t, shared_ptr<RuleViolation> > RuleViolationsMap;
 typedef std::map<Tile*, RefreshBlock_t> RefreshTiles;
 typedef std::vector< std::pair<std::string, uint32_t> > Highscore;
 typedef std::list<Position> Trash;
+// tiles holding movable items that did not come with the map, in map order
+typedef std::set<Position> DirtyTiles;
 typedef std::map<int32_t, float> StageList;
 
+struct ThinkStats
+{
+	ThinkStats(): skipped(0) {memset(thinks, 0, sizeof(thinks));}
+	uint64_t thinks[THINKTIER_LAST], skipped;
+};
+
+struct CleanMapState
+{
+	CleanMapState(): running(false), started(false), reopen(false), slice(0), count(0), start(0) {}
+
+	// reopen: set the game state back to normal after the last slice
+	bool running, started, reopen;
+	// last tile cleaned, the next slice resumes right after it
+	Position pos;
+	uint32_t slice, count;
+	uint64_t start;
+};
+
 #define EVENT_LIGHTINTERVAL 10000
 #define EVENT_DECAYINTERVAL 1000
-#define EVENT_DECAYBUCKETS 16
+#define EVENT_CLEANMAPINTERVAL 100
 #define STATE_DELAY 1000
 #ifdef __WAR_SYSTEM__
 #define EVENT_WARSINTERVAL 900000
@@ -327,6 +348,7 @@ class Game
 
 		void addCreatureCheck(Creature* creature);
 		void removeCreatureCheck(Creature* creature);
+		const ThinkStats& getThinkStats() const {return thinkStats;}
 
 		uint32_t getPlayersOnline() {return (uint32_t)Player::autoList.size();}
 		uint32_t getMonstersOnline() {return (uint32_t)Monster::autoList.size();}
@@ -341,7 +363,12 @@ class Game
 			int32_t minRangeY = 0, int32_t maxRangeY = 0)
 			{map->getSpectators(list, centerPos, checkforduplicate, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY);}
 		const SpectatorVec& getSpectators(const Position& centerPos) {return map->getSpectators(centerPos);}
-		void clearSpectatorCache() {if(map) map->clearSpectatorCache();}
+		void getPlayerSpectators(SpectatorVec& list, const Position& centerPos, bool multifloor = false,
+			int32_t minRangeX = 0, int32_t maxRangeX = 0,
+			int32_t minRangeY = 0, int32_t maxRangeY = 0)
+			{map->getPlayerSpectators(list, centerPos, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY);}
+		const SpectatorVec& getPlayerSpectators(const Position& centerPos) {return map->getPlayerSpectators(centerPos);}
+		void releaseTaskCaches() {if(map) map->releaseTaskCaches();}
 
 		ReturnValue internalMoveCreature(Creature* creature, Direction direction, uint32_t flags = 0);
 		ReturnValue internalMoveCreature(Creature* actor, Creature* creature, Cylinder* fromCylinder,
@@ -538,10 +565,12 @@ class Game
 		bool isSightClear(const Position& fromPos, const Position& toPos, bool sameFloor);
 
 		bool getPathTo(const Creature* creature, const Position& destPos,
-			std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/);
+			std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/, uint32_t maxNodes = MAX_NODES);
 
 		bool getPathToEx(const Creature* creature, const Position& targetPos, std::list<Direction>& dirList,
 			const FindPathParams& fpp);
+		bool getPathByFlowField(const Creature* creature, const Creature* target, std::list<Direction>& dirList,
+			const FindPathParams& fpp) {return map->getPathByFlowField(creature, target, dirList, fpp);}
 
 		bool getPathToEx(const Creature* creature, const Position& targetPos, std::list<Direction>& dirList,
 			uint32_t minTargetDist, uint32_t maxTargetDist, bool fullPathSearch = true,
@@ -570,12 +599,18 @@ class Game
 		void loadGameState();
 
 		void cleanMapEx(uint32_t& count);
-		void cleanMap();
+		// cleans cleanMapSlice tiles every EVENT_CLEANMAPINTERVAL when set,
+		// otherwise the same as cleanMapEx, true while slices are still to come;
+		// reopen opens the server again once the clean is done
+		bool cleanMap(bool reopen = false);
 
 		void refreshMap(RefreshTiles::iterator* it = NULL, uint32_t limit = 0);
 		void proceduralRefresh(RefreshTiles::iterator* it = NULL);
 
 		void addTrash(Position pos) {trash.push_back(pos);}
+		void addDirtyTile(const Position& pos) {dirtyTiles.insert(pos);}
+		void removeDirtyTile(const Position& pos) {dirtyTiles.erase(pos);}
+		uint32_t getDirtyTileCount() const {return dirtyTiles.size();}
 		void addRefreshTile(Tile* tile, RefreshBlock_t rb) {refreshTiles[tile] = rb;}
 
 		//Events
@@ -628,6 +663,17 @@ class Game
 		bool isRunning() const {return services && services->isRunning();}
 		int32_t getLightHour() const {return lightHour;}
 		void startDecay(Item* item);
+		// puts an item whose decay is running (again) on the wheel
+		void scheduleDecay(Item* item);
+		// bulk pause of an item and its contents, e.g. when put away in a depot or
+		// house, the remaining time is kept until resumeDecay
+		void pauseDecay(Item* item);
+		void resumeDecay(Item* item);
+		// pauses or resumes an item that entered or left a depot or house
+		void updateStoredDecay(Item* item);
+		bool isStoredItem(const Item* item) const;
+		uint32_t getDecayingCount() const {return decayWheel.size();}
+		const DecayStats& getDecayStats() {return decayWheel.getStats();}
 		void parsePlayerExtendedOpcode(uint32_t playerId, uint8_t opcode, const std::string& buffer);
 
 	protected:
@@ -654,14 +700,14 @@ class Game
 		size_t checkCreatureLastIndex;
 		std::vector<Creature*> checkCreatureVectors[EVENT_CREATURECOUNT];
 		std::vector<Creature*> toAddCheckCreatureVector;
+		ThinkStats thinkStats;
+		// how often a creature thinks, slower the further players are
+		ThinkTier_t getThinkTier(const Creature* creature);
 
 		void checkDecay();
 		void internalDecayItem(Item* item);
 
-		typedef std::list<Item*> DecayList;
-		DecayList decayItems[EVENT_DECAYBUCKETS];
-		DecayList toDecayItems;
-		size_t lastBucket;
+		DecayWheel decayWheel;
 
 		static const int32_t LIGHT_LEVEL_DAY = 250;
 		static const int32_t LIGHT_LEVEL_NIGHT = 40;
@@ -687,6 +733,14 @@ class Game
 
 		RefreshTiles refreshTiles;
 		Trash trash;
+		DirtyTiles dirtyTiles;
+		CleanMapState cleanMapState;
+
+		// removes the movable items that did not come with the map, false
+		// when the tile is skipped
+		bool cleanTile(Tile* tile, bool cleanProtected, uint32_t& count);
+		uint32_t getCleanMapTileCount(bool cleanProtected) const;
+		void cleanMapSlice();
 
 		StageList stages;
 		uint32_t lastStageLevel;
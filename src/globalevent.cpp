@@ -99,9 +99,9 @@ bool GlobalEvents::registerEvent(Event* event, const pugi::xml_node&, bool overr
 void GlobalEvents::startup()
 {
 	execute(GLOBALEVENT_STARTUP);
-	g_scheduler.addEvent(createSchedulerTask(TIMER_INTERVAL,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("GlobalEvents::startup", TIMER_INTERVAL,
 		std::bind(&GlobalEvents::timer, this)));
-	g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("GlobalEvents::startup", SCHEDULER_MINTICKS,
 		std::bind(&GlobalEvents::think, this)));
 }
 
@@ -120,7 +120,7 @@ void GlobalEvents::timer()
 				<< it->second->getName() << std::endl;
 	}
 
-	g_scheduler.addEvent(createSchedulerTask(TIMER_INTERVAL,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("GlobalEvents::timer", TIMER_INTERVAL,
 		std::bind(&GlobalEvents::timer, this)));
 }
 
@@ -138,7 +138,7 @@ void GlobalEvents::think()
 				<< it->second->getName() << std::endl;
 	}
 
-	g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS,
+	g_scheduler.addEvent(createSchedulerTaskWithOrigin("GlobalEvents::think", SCHEDULER_MINTICKS,
 		std::bind(&GlobalEvents::think, this)));
 }
 
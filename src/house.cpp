@@ -46,6 +46,7 @@ House::House(uint32_t houseId)
 void House::addTile(HouseTile* tile)
 {
 	tile->setFlag(TILESTATE_PROTECTIONZONE);
+	tile->updateWalkBits();
 	houseTiles.push_back(tile);
 }
 
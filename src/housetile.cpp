@@ -52,6 +52,25 @@ void HouseTile::__internalAddThing(uint32_t index, Thing* thing)
 		updateHouse(item);
 }
 
+void HouseTile::postAddNotification(Creature* actor, Thing* thing, const Cylinder* oldParent,
+	int32_t index, cylinderlink_t link/* = LINK_OWNER*/)
+{
+	if(Item* item = thing->getItem())
+		g_game.updateStoredDecay(item);
+
+	Tile::postAddNotification(actor, thing, oldParent, index, link);
+}
+
+void HouseTile::postRemoveNotification(Creature* actor, Thing* thing, const Cylinder* newParent,
+	int32_t index, bool isCompleteRemoval, cylinderlink_t link/* = LINK_OWNER*/)
+{
+	Item* item = thing->getItem();
+	if(item && !isCompleteRemoval)
+		g_game.updateStoredDecay(item);
+
+	Tile::postRemoveNotification(actor, thing, newParent, index, isCompleteRemoval, link);
+}
+
 void HouseTile::updateHouse(Item* item)
 {
 	if(item->getTile() != this)
@@ -459,7 +459,7 @@ bool IOGuild::updateWar(War_t& war)
 	result->free();
 	if(war.frags[WAR_GUILD] >= war.limit || war.frags[WAR_ENEMY] >= war.limit)
 	{
-		g_scheduler.addEvent(createSchedulerTask(3000,
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("IOGuild::updateWar", 3000,
 			std::bind(&IOGuild::finishWar, this, war, true)));
 		return true;
 	}
@@ -370,9 +370,9 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 								}
 								else if(tile)
 								{
+									item->setLoadedFromMap(true);
 									tile->__internalAddThing(item);
 									item->__startDecaying();
-									item->setLoadedFromMap(true);
 								}
 								else if(item->isGroundTile())
 								{
@@ -383,10 +383,10 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 								else
 								{
 									tile = createTile(ground, item, px, py, pz);
+									item->setLoadedFromMap(true);
 									tile->__internalAddThing(item);
 
 									item->__startDecaying();
-									item->setLoadedFromMap(true);
 								}
 
 								break;
@@ -437,9 +437,9 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 								}
 								else if(tile)
 								{
+									item->setLoadedFromMap(true);
 									tile->__internalAddThing(item);
 									item->__startDecaying();
-									item->setLoadedFromMap(true);
 								}
 								else if(item->isGroundTile())
 								{
@@ -450,10 +450,10 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 								else
 								{
 									tile = createTile(ground, item, px, py, pz);
+									item->setLoadedFromMap(true);
 									tile->__internalAddThing(item);
 
 									item->__startDecaying();
-									item->setLoadedFromMap(true);
 								}
 							}
 							else
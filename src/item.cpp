@@ -169,6 +169,7 @@ Item::Item(const uint16_t type, uint16_t amount/* = 0*/):
 {
 	raid = NULL;
 	loadedFromMap = false;
+	decayExpiry = 0;
 
 	count = 1;
 	setDefaultDuration();
@@ -196,6 +197,9 @@ Item* Item::clone() const
 
 	tmp->createAttributes();
 	*tmp->attributes = *attributes;
+	if(decayExpiry)
+		tmp->setAttribute("duration", getDuration());
+
 	return tmp;
 }
 
@@ -232,8 +236,33 @@ void Item::setDefaultSubtype()
 		setCharges(it.charges);
 }
 
+void Item::setDuration(int32_t time)
+{
+	setAttribute("duration", time);
+	if(!decayExpiry)
+		return;
+
+	//still decaying, the old entry of the wheel goes stale
+	decayExpiry = 0;
+	g_game.scheduleDecay(this);
+}
+
+void Item::resetDecayExpiry()
+{
+	if(!decayExpiry)
+		return;
+
+	setAttribute("duration", getDuration());
+	decayExpiry = 0;
+}
+
 void Item::setID(uint16_t newId)
 {
+	//a running decay goes on as the new type, checkDecay drops the old entry
+	bool decaying = decayExpiry != 0;
+	if(decaying)
+		resetDecayExpiry();
+
 	const ItemType& it = Item::items[newId];
 	const ItemType& pit = Item::items[id];
 	id = newId;
@@ -251,6 +280,17 @@ void Item::setID(uint16_t newId)
 		setDecaying(DECAYING_FALSE);
 		setDuration(newDuration);
 	}
+
+	if(!decaying)
+		return;
+
+	if(canDecay())
+	{
+		setDecaying(DECAYING_TRUE);
+		g_game.scheduleDecay(this);
+	}
+	else
+		setDecaying(DECAYING_FALSE);
 }
 
 bool Item::floorChange(FloorChange_t change/* = CHANGE_NONE*/) const
@@ -539,7 +579,7 @@ Attr_ReadValue Item::readAttr(AttrTypes_t attr, PropStream& propStream)
 			if(!propStream.getByte(state))
 				return ATTR_READ_ERROR;
 
-			if((ItemDecayState_t)state != DECAYING_FALSE)
+			if((ItemDecayState_t)state != DECAYING_FALSE && (ItemDecayState_t)state != DECAYING_PAUSED)
 				setAttribute("decaying", (int32_t)DECAYING_PENDING);
 
 			break;
@@ -614,7 +654,7 @@ Attr_ReadValue Item::readAttr(AttrTypes_t attr, PropStream& propStream)
 				ScriptEnviroment::addUniqueThing(this);
 
 			// this attribute has a custom behavior as well
-			if(getDecaying() != DECAYING_FALSE)
+			if(getDecaying() != DECAYING_FALSE && getDecaying() != DECAYING_PAUSED)
 				setDecaying(DECAYING_PENDING);
 
 			if(ret)
@@ -659,6 +699,9 @@ bool Item::serializeAttr(PropWriteStream& propWriteStream) const
 
 	if(attributes && !attributes->empty())
 	{
+		if(decayExpiry)
+			const_cast<Item*>(this)->setAttribute("duration", getDuration());
+
 		propWriteStream.addByte(ATTR_ATTRIBUTE_MAP);
 		serializeMap(propWriteStream);
 	}
@@ -65,7 +65,8 @@ enum ItemDecayState_t
 {
 	DECAYING_FALSE = 0,
 	DECAYING_TRUE,
-	DECAYING_PENDING
+	DECAYING_PENDING,
+	DECAYING_PAUSED // only Game::resumeDecay starts it again
 };
 
 enum AttrTypes_t
@@ -195,10 +196,17 @@ class Item : virtual public Thing, public ItemAttributes
 		virtual bool unserializeItemNode(FileLoader&, NODE, PropStream& propStream) {return unserializeAttr(propStream);}
 
 		// Item attributes
-		void setDuration(int32_t time) {setAttribute("duration", time);}
+		void setDuration(int32_t time);
 		void decreaseDuration(int32_t time);
 		int32_t getDuration() const;
 
+		// time the running decay ends, 0 when not scheduled, the duration
+		// attribute of a scheduled item is only updated when asked for
+		int64_t getDecayExpiry() const {return decayExpiry;}
+		void setDecayExpiry(int64_t expiry) {decayExpiry = expiry;}
+		// writes the remaining time back to the duration and unschedules it
+		void resetDecayExpiry();
+
 		void setSpecialDescription(const std::string& description) {setAttribute("description", description);}
 		void resetSpecialDescription() {eraseAttribute("description");}
 		std::string getSpecialDescription() const;
@@ -336,6 +344,7 @@ class Item : virtual public Thing, public ItemAttributes
 
 		Raid* raid;
 		bool loadedFromMap;
+		int64_t decayExpiry;
 };
 
 inline std::string Item::getName() const
@@ -464,6 +473,9 @@ inline void Item::decreaseDuration(int32_t time)
 
 inline int32_t Item::getDuration() const
 {
+	if(decayExpiry)
+		return (int32_t)std::max((int64_t)0, decayExpiry - OTSYS_TIME());
+
 	const int32_t* v = getIntegerAttribute("duration");
 	if(v)
 		return *v;
@@ -1793,6 +1793,12 @@ void LuaInterface::registerFunctions()
 	//doDecayItem(uid)
 	lua_register(m_luaState, "doDecayItem", LuaInterface::luaDoDecayItem);
 
+	//doPauseItemDecay(uid)
+	lua_register(m_luaState, "doPauseItemDecay", LuaInterface::luaDoPauseItemDecay);
+
+	//doResumeItemDecay(uid)
+	lua_register(m_luaState, "doResumeItemDecay", LuaInterface::luaDoResumeItemDecay);
+
 	//doCreateItem(itemid[, type/count], pos)
 	//Returns uid of the created item, only works on tiles.
 	lua_register(m_luaState, "doCreateItem", LuaInterface::luaDoCreateItem);
@@ -4691,6 +4697,43 @@ int32_t LuaInterface::luaDoDecayItem(lua_State* L)
 	return 1;
 }
 
+int32_t LuaInterface::luaDoPauseItemDecay(lua_State* L)
+{
+	//doPauseItemDecay(uid)
+	//Note: pauses the contents of containers as well
+	ScriptEnviroment* env = getEnv();
+	if(Item* item = env->getItemByUID(popNumber(L)))
+	{
+		g_game.pauseDecay(item);
+		lua_pushboolean(L, true);
+	}
+	else
+	{
+		errorEx(getError(LUA_ERROR_ITEM_NOT_FOUND));
+		lua_pushboolean(L, false);
+	}
+
+	return 1;
+}
+
+int32_t LuaInterface::luaDoResumeItemDecay(lua_State* L)
+{
+	//doResumeItemDecay(uid)
+	ScriptEnviroment* env = getEnv();
+	if(Item* item = env->getItemByUID(popNumber(L)))
+	{
+		g_game.resumeDecay(item);
+		lua_pushboolean(L, true);
+	}
+	else
+	{
+		errorEx(getError(LUA_ERROR_ITEM_NOT_FOUND));
+		lua_pushboolean(L, false);
+	}
+
+	return 1;
+}
+
 int32_t LuaInterface::luaGetThingFromPos(lua_State* L)
 {
 	//getThingFromPos(pos[, displayError = true])
@@ -8880,7 +8923,7 @@ int32_t LuaInterface::luaAddEvent(lua_State* L)
 		params.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
 
 	LuaTimerEvent event;
-	event.eventId = g_scheduler.addEvent(createSchedulerTask(std::max((int64_t)SCHEDULER_MINTICKS, popNumber(L)),
+	event.eventId = g_scheduler.addEvent(createSchedulerTaskWithOrigin("LuaInterface::luaAddEvent", std::max((int64_t)SCHEDULER_MINTICKS, popNumber(L)),
 		std::bind(&LuaInterface::executeTimer, interface, ++interface->m_lastTimer)));
 
 	event.parameters = params;
@@ -9892,7 +9935,7 @@ int32_t LuaInterface::luaDoSetGameState(lua_State* L)
 	uint32_t id = popNumber(L);
 	if(id >= GAMESTATE_FIRST && id <= GAMESTATE_LAST)
 	{
-		g_dispatcher.addTask(createTask(
+		g_dispatcher.addTask(createTaskWithOrigin("LuaInterface::luaDoSetGameState",
 			std::bind(&Game::setGameState, &g_game, (GameState_t)id)));
 		lua_pushboolean(L, true);
 	}
@@ -9960,7 +10003,7 @@ int32_t LuaInterface::luaDoReloadInfo(lua_State* L)
 	{
 		// we're passing it to scheduler since talkactions reload will
 		// re-init our lua state and crash due to unfinished call
-		g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS,
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("LuaInterface::luaDoReloadInfo", SCHEDULER_MINTICKS,
 			std::bind(&Game::reloadInfo, &g_game, (ReloadInfo_t)id, cid)));
 		lua_pushboolean(L, true);
 	}
@@ -9977,7 +10020,7 @@ int32_t LuaInterface::luaDoSaveServer(lua_State* L)
 	if(lua_gettop(L) > 0)
 		shallow = popNumber(L);
 
-	g_dispatcher.addTask(createTask(std::bind(&Game::saveGameState, &g_game, shallow)));
+	g_dispatcher.addTask(createTaskWithOrigin("LuaInterface::luaDoSaveServer", std::bind(&Game::saveGameState, &g_game, shallow)));
 	lua_pushnil(L);
 	return 1;
 }
@@ -10186,6 +10229,9 @@ int32_t LuaInterface::luaGetItemAttribute(lua_State* L)
 	}
 
 	boost::any value = item->getAttribute(key);
+	if(key == "duration" && !value.empty()) //the stored one is behind while decaying
+		value = item->getDuration();
+
 	if(value.empty())
 		lua_pushnil(L);
 	else if(value.type() == typeid(std::string))
@@ -10254,6 +10300,8 @@ int32_t LuaInterface::luaDoItemSetAttribute(lua_State* L)
 		}
 		else if(key == "aid")
 			item->setActionId(boost::any_cast<int32_t>(value));
+		else if(key == "duration")
+			item->setDuration(boost::any_cast<int32_t>(value));
 		else
 			item->setAttribute(key, boost::any_cast<int32_t>(value));
 	}
@@ -362,6 +362,8 @@ class LuaInterface
 		static int32_t luaDoShowTextWindow(lua_State* L);
 		static int32_t luaDoShowTextDialog(lua_State* L);
 		static int32_t luaDoDecayItem(lua_State* L);
+		static int32_t luaDoPauseItemDecay(lua_State* L);
+		static int32_t luaDoResumeItemDecay(lua_State* L);
 		static int32_t luaDoCreateItem(lua_State* L);
 		static int32_t luaDoCreateItemEx(lua_State* L);
 		static int32_t luaDoCreateTeleport(lua_State* L);
@@ -22,24 +22,39 @@
 #include "tile.h"
 
 #include "creature.h"
+#include "pathfinding.h"
 #include "player.h"
 #include "combat.h"
 
 #include "iomapserialize.h"
 #include "items.h"
 #include "game.h"
+#include "configmanager.h"
 
+extern ConfigManager g_config;
 extern Game g_game;
 
 Map::Map()
 {
 	mapWidth = 0;
 	mapHeight = 0;
+	sightSequence = 0;
+	regionRadius = 0;
 }
 
 bool Map::loadMap(const std::string& identifier)
 {
 	int64_t start = OTSYS_TIME();
+	//never less than a player can see, or creatures on screen would be suspended
+	int32_t radius = g_config.getNumber(ConfigManager::REGION_ACTIVATION_RADIUS);
+	if(radius > 0 && radius < maxViewportX)
+		radius = maxViewportX;
+
+	if(radius > 0 && radius < maxViewportY)
+		radius = maxViewportY;
+
+	regionRadius = std::max((int32_t)0, (radius + FLOOR_MASK) >> FLOOR_BITS);
+
 	IOMap* loader = new IOMap();
 	if(!loader->loadMap(this, identifier))
 	{
@@ -105,7 +120,11 @@ Tile* Map::getTile(int32_t x, int32_t y, int32_t z)
 	if(x < 0 || x > 0xFFFF || y < 0 || y > 0xFFFF || z < 0 || z >= MAP_MAX_LAYERS)
 		return NULL;
 
+#ifdef __FLAT_MAP_GRID__
+	QTreeLeafNode* leaf = grid.getLeaf(x, y);
+#else
 	QTreeLeafNode* leaf = QTreeNode::getLeafStatic(&root, x, y);
+#endif
 	if(!leaf)
 		return NULL;
 
@@ -125,26 +144,30 @@ void Map::setTile(uint16_t x, uint16_t y, uint16_t z, Tile* newTile)
 	}
 
 	QTreeLeafNode::newLeaf = false;
+#ifdef __FLAT_MAP_GRID__
+	QTreeLeafNode* leaf = grid.createLeaf(x, y);
+#else
 	QTreeLeafNode* leaf = root.createLeaf(x, y, 15);
+#endif
 	if(QTreeLeafNode::newLeaf)
 	{
 		//update north
-		QTreeLeafNode* northLeaf = root.getLeaf(x, y - FLOOR_SIZE);
+		QTreeLeafNode* northLeaf = getLeaf(x, y - FLOOR_SIZE);
 		if(northLeaf)
 			northLeaf->m_leafS = leaf;
 
 		//update west leaf
-		QTreeLeafNode* westLeaf = root.getLeaf(x - FLOOR_SIZE, y);
+		QTreeLeafNode* westLeaf = getLeaf(x - FLOOR_SIZE, y);
 		if(westLeaf)
 			westLeaf->m_leafE = leaf;
 
 		//update south
-		QTreeLeafNode* southLeaf = root.getLeaf(x, y + FLOOR_SIZE);
+		QTreeLeafNode* southLeaf = getLeaf(x, y + FLOOR_SIZE);
 		if(southLeaf)
 			leaf->m_leafS = southLeaf;
 
 		//update east
-		QTreeLeafNode* eastLeaf = root.getLeaf(x + FLOOR_SIZE, y);
+		QTreeLeafNode* eastLeaf = getLeaf(x + FLOOR_SIZE, y);
 		if(eastLeaf)
 			leaf->m_leafE = eastLeaf;
 	}
@@ -155,6 +178,7 @@ void Map::setTile(uint16_t x, uint16_t y, uint16_t z, Tile* newTile)
 	{
 		floor->tiles[offsetX][offsetY] = newTile;
 		newTile->qt_node = leaf;
+		floor->updateBits(offsetX, offsetY, newTile);
 	}
 	else
 		std::clog << "[Error - Map::setTile] Tile already exists - pos " << offsetX << "/" << offsetY << "/" << z << std::endl;
@@ -253,7 +277,11 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 	{
 		toCylinder->__internalAddThing(creature);
 		if(Tile* toTile = toCylinder->getTile())
+		{
 			toTile->qt_node->addCreature(creature);
+			if(creature->getPlayer())
+				updateRegionActivation(toTile->getPosition(), 1);
+		}
 	}
 
 	return true;
@@ -266,21 +294,145 @@ bool Map::removeCreature(Creature* creature)
 		return false;
 
 	tile->qt_node->removeCreature(creature);
+	if(creature->getPlayer())
+		updateRegionActivation(tile->getPosition(), -1);
+
+	//nobody can chase it anymore
+	flowFields.erase(creature->getID());
 	tile->__removeThing(creature, 0);
 	return true;
 }
 
-void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, bool checkForDuplicate,
-	int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY,
-	int32_t minRangeZ, int32_t maxRangeZ)
+void Map::onCreatureChangeLeaf(Creature* creature, const Position& oldPos, const Position& newPos)
+{
+	if(creature->getPlayer())
+	{
+		//activate first so that the leaves both areas share never drop to zero
+		updateRegionActivation(newPos, 1);
+		updateRegionActivation(oldPos, -1);
+	}
+	else if(creature->isSuspended() && isRegionActive(newPos))
+	{
+		++regionStats.woken;
+		g_game.addCreatureCheck(creature);
+	}
+}
+
+bool Map::isRegionActive(const Position& pos)
+{
+	if(!regionRadius)
+		return true;
+
+	QTreeLeafNode* leaf = getLeaf(pos.x, pos.y);
+	return !leaf || leaf->m_activePlayers;
+}
+
+bool Map::isRegionActive(const Creature* creature) const
+{
+	if(!regionRadius)
+		return true;
+
+	const Tile* tile = creature->getTile();
+	return !tile || !tile->qt_node || tile->qt_node->m_activePlayers;
+}
+
+void Map::updateRegionActivation(const Position& pos, int32_t change)
+{
+	if(!regionRadius)
+		return;
+
+	int32_t startX = std::max((int32_t)0, (pos.x >> FLOOR_BITS) - regionRadius),
+		endX = std::min((int32_t)(0xFFFF >> FLOOR_BITS), (pos.x >> FLOOR_BITS) + regionRadius),
+		startY = std::max((int32_t)0, (pos.y >> FLOOR_BITS) - regionRadius),
+		endY = std::min((int32_t)(0xFFFF >> FLOOR_BITS), (pos.y >> FLOOR_BITS) + regionRadius);
+	for(int32_t ly = startY; ly <= endY; ++ly)
+	{
+		for(int32_t lx = startX; lx <= endX; ++lx)
+		{
+			QTreeLeafNode* leaf = getLeaf(lx << FLOOR_BITS, ly << FLOOR_BITS);
+			if(!leaf)
+				continue;
+
+			leaf->m_activePlayers += change;
+			if(change < 0)
+			{
+				//no player is close enough to be sent these tiles any more
+				if(!leaf->m_activePlayers)
+					leaf->resetTileDescriptions();
+
+				continue;
+			}
+
+			if(leaf->m_activePlayers != 1)
+				continue;
+
+			//the creatures suspended here are put back, the rest are
+			//unscheduled lazily by Game::checkCreatures
+			++regionStats.activated;
+			for(CreatureVector::iterator it = leaf->creatureList.begin(); it != leaf->creatureList.end(); ++it)
+			{
+				if(!(*it)->isSuspended())
+					continue;
+
+				++regionStats.woken;
+				g_game.addCreatureCheck(*it);
+			}
+		}
+	}
+}
+
+static inline void getSpectatorLeafBounds(const Position& centerPos, int32_t minRangeX, int32_t maxRangeX,
+	int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ, int32_t maxRangeZ,
+	int32_t& startX, int32_t& startY, int32_t& endX, int32_t& endY)
 {
 	int32_t minoffset = centerPos.z - maxRangeZ, maxoffset = centerPos.z - minRangeZ,
 		x1 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.x + minRangeX + minoffset))),
 		y1 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.y + minRangeY + minoffset))),
 		x2 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.x + maxRangeX + maxoffset))),
-		y2 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.y + maxRangeY + maxoffset))),
-		startx1 = x1 - (x1 % FLOOR_SIZE), starty1 = y1 - (y1 % FLOOR_SIZE),
-		endx2 = x2 - (x2 % FLOOR_SIZE), endy2 = y2 - (y2 % FLOOR_SIZE);
+		y2 = std::min((int32_t)0xFFFF, std::max((int32_t)0, (centerPos.y + maxRangeY + maxoffset)));
+
+	startX = x1 - (x1 % FLOOR_SIZE);
+	startY = y1 - (y1 % FLOOR_SIZE);
+	endX = x2 - (x2 % FLOOR_SIZE);
+	endY = y2 - (y2 % FLOOR_SIZE);
+}
+
+static inline void getMultifloorRange(const Position& centerPos, int32_t& minRangeZ, int32_t& maxRangeZ)
+{
+	if(centerPos.z > 7)
+	{
+		//underground, 8->15
+		minRangeZ = std::max(centerPos.z - 2, 0);
+		maxRangeZ = std::min(centerPos.z + 2, MAP_MAX_LAYERS - 1);
+	}
+	//above ground
+	else if(centerPos.z == 6)
+	{
+		minRangeZ = 0;
+		maxRangeZ = 8;
+	}
+	else if(centerPos.z == 7)
+	{
+		minRangeZ = 0;
+		maxRangeZ = 9;
+	}
+	else
+	{
+		minRangeZ = 0;
+		maxRangeZ = 7;
+	}
+}
+
+void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, bool checkForDuplicate,
+	int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY,
+	int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers/* = false*/)
+{
+	int32_t startx1, starty1, endx2, endy2;
+	getSpectatorLeafBounds(centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY,
+		minRangeZ, maxRangeZ, startx1, starty1, endx2, endy2);
+
+	//a creature belongs to a single leaf, so only what was in the list before can be a duplicate
+	uint32_t previousSize = (checkForDuplicate ? list.size() : 0);
 
 	QTreeLeafNode* startLeaf = getLeaf(startx1, starty1);
 	QTreeLeafNode* leafS = startLeaf;
@@ -293,7 +445,7 @@ void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, b
 		{
 			if(leafE)
 			{
-				CreatureVector& nodeList = leafE->creatureList;
+				CreatureVector& nodeList = (onlyPlayers ? leafE->playerList : leafE->creatureList);
 				CreatureVector::const_iterator it = nodeList.begin();
 				if(it != nodeList.end())
 				{
@@ -312,7 +464,7 @@ void Map::getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, b
 						if(pos.x < (centerPos.x + minRangeX + offsetZ) || pos.x > (centerPos.x + maxRangeX + offsetZ))
 							continue;
 
-						if(!checkForDuplicate || std::find(list.begin(), list.end(), creature) == list.end())
+						if(!previousSize || std::find(list.begin(), list.begin() + previousSize, creature) == list.begin() + previousSize)
 							list.push_back(creature);
 					}
 					while(++it != nodeList.end());
@@ -337,110 +489,155 @@ void Map::getSpectators(SpectatorVec& list, const Position& centerPos, bool chec
 	if(centerPos.z >= MAP_MAX_LAYERS)
 		return;
 
-	bool foundCache = false, cacheResult = false;
-	if(!minRangeX && !maxRangeX && !minRangeY && !maxRangeY && multifloor && !checkforduplicate)
-	{
-		SpectatorCache::iterator it = spectatorCache.find(centerPos);
-		if(it != spectatorCache.end())
-		{
-			list = *it->second;
-			foundCache = true;
-		}
-		else
-			cacheResult = true;
-	}
-
-	if(!foundCache)
-	{
-		minRangeX = (!minRangeX ? -maxViewportX : -minRangeX);
-		maxRangeX = (!maxRangeX ? maxViewportX : maxRangeX);
-		minRangeY = (!minRangeY ? -maxViewportY : -minRangeY);
-		maxRangeY = (!maxRangeY ? maxViewportY : maxRangeY);
+	if(!minRangeX && !maxRangeX && !minRangeY && !maxRangeY && multifloor && !checkforduplicate && list.empty())
+		list = getSpectators(centerPos);
+	else
+		getSpectatorsInRange(list, centerPos, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY, false);
+}
 
-		int32_t minRangeZ, maxRangeZ;
-		if(multifloor)
-		{
-			if(centerPos.z > 7)
-			{
-				//underground, 8->15
-				minRangeZ = std::max(centerPos.z - 2, 0);
-				maxRangeZ = std::min(centerPos.z + 2, MAP_MAX_LAYERS - 1);
-			}
-			//above ground
-			else if(centerPos.z == 6)
-			{
-				minRangeZ = 0;
-				maxRangeZ = 8;
-			}
-			else if(centerPos.z == 7)
-			{
-				minRangeZ = 0;
-				maxRangeZ = 9;
-			}
-			else
-			{
-				minRangeZ = 0;
-				maxRangeZ = 7;
-			}
-		}
-		else
-		{
-			minRangeZ = centerPos.z;
-			maxRangeZ = centerPos.z;
-		}
+void Map::getPlayerSpectators(SpectatorVec& list, const Position& centerPos, bool multifloor /*= false*/,
+	int32_t minRangeX /*= 0*/, int32_t maxRangeX /*= 0*/, int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/)
+{
+	if(centerPos.z >= MAP_MAX_LAYERS)
+		return;
 
-		getSpectatorsInternal(list, centerPos, true, minRangeX,
-			maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ);
+	if(!minRangeX && !maxRangeX && !minRangeY && !maxRangeY && multifloor && list.empty())
+		list = getPlayerSpectators(centerPos);
+	else
+		getSpectatorsInRange(list, centerPos, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY, true);
+}
 
-		if(cacheResult)
-			spectatorCache[centerPos].reset(new SpectatorVec(list));
+void Map::getSpectatorsInRange(SpectatorVec& list, const Position& centerPos, bool multifloor,
+	int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, bool onlyPlayers)
+{
+	minRangeX = (!minRangeX ? -maxViewportX : -minRangeX);
+	maxRangeX = (!maxRangeX ? maxViewportX : maxRangeX);
+	minRangeY = (!minRangeY ? -maxViewportY : -minRangeY);
+	maxRangeY = (!maxRangeY ? maxViewportY : maxRangeY);
+
+	int32_t minRangeZ, maxRangeZ;
+	if(multifloor)
+		getMultifloorRange(centerPos, minRangeZ, maxRangeZ);
+	else
+	{
+		minRangeZ = centerPos.z;
+		maxRangeZ = centerPos.z;
 	}
+
+	getSpectatorsInternal(list, centerPos, true, minRangeX,
+		maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ, onlyPlayers);
 }
 
 const SpectatorVec& Map::getSpectators(const Position& centerPos)
 {
+	return getCachedSpectators(spectatorCache, centerPos, false);
+}
+
+const SpectatorVec& Map::getPlayerSpectators(const Position& centerPos)
+{
+	return getCachedSpectators(playerSpectatorCache, centerPos, true);
+}
+
+const SpectatorVec& Map::getCachedSpectators(SpectatorCache& cache, const Position& centerPos, bool onlyPlayers)
+{
+	static const SpectatorVec emptyList;
 	if(centerPos.z >= MAP_MAX_LAYERS)
+		return emptyList;
+
+	SpectatorCache::iterator it = cache.find(centerPos);
+	if(it != cache.end())
 	{
-		std::shared_ptr<SpectatorVec> p(new SpectatorVec());
-		SpectatorVec& list = *p;
-		return list;
-	}
+		if(isSpectatorCacheValid(it->second, onlyPlayers))
+			return *it->second.list;
 
-	SpectatorCache::iterator it = spectatorCache.find(centerPos);
-	if(it != spectatorCache.end())
-		return *it->second;
+		//a creature moved around here, but the old list may still be iterated
+		retiredSpectators.push_back(it->second.list);
+	}
+	else
+		it = cache.insert(std::make_pair(centerPos, SpectatorCacheEntry())).first;
 
-	std::shared_ptr<SpectatorVec> p(new SpectatorVec());
-	spectatorCache[centerPos] = p;
-	SpectatorVec& list = *p;
+	SpectatorCacheEntry& entry = it->second;
+	if(!spectatorPool.empty())
+	{
+		entry.list = spectatorPool.back();
+		spectatorPool.pop_back();
+	}
+	else
+		entry.list.reset(new SpectatorVec());
 
 	int32_t minRangeX = -maxViewportX, maxRangeX = maxViewportX, minRangeY = -maxViewportY,
 		maxRangeY = maxViewportY, minRangeZ, maxRangeZ;
-	if(centerPos.z > 7)
-	{
-		//underground, 8->15
-		minRangeZ = std::max(centerPos.z - 2, 0);
-		maxRangeZ = std::min(centerPos.z + 2, MAP_MAX_LAYERS - 1);
-	}
-	//above ground
-	else if(centerPos.z == 6)
+	getMultifloorRange(centerPos, minRangeZ, maxRangeZ);
+
+	getSpectatorLeafBounds(centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY,
+		minRangeZ, maxRangeZ, entry.startX, entry.startY, entry.endX, entry.endY);
+	entry.sequence = QTreeLeafNode::getChangeSequence();
+
+	getSpectatorsInternal(*entry.list, centerPos, false, minRangeX, maxRangeX,
+		minRangeY, maxRangeY, minRangeZ, maxRangeZ, onlyPlayers);
+	return *entry.list;
+}
+
+bool Map::isSpectatorCacheValid(SpectatorCacheEntry& entry, bool onlyPlayers)
+{
+	uint64_t sequence = QTreeLeafNode::getChangeSequence();
+	if(entry.sequence == sequence)
+		return true;
+
+	QTreeLeafNode* leafS = getLeaf(entry.startX, entry.startY);
+	QTreeLeafNode* leafE;
+	for(int32_t ny = entry.startY; ny <= entry.endY; ny += FLOOR_SIZE)
 	{
-		minRangeZ = 0;
-		maxRangeZ = 8;
+		leafE = leafS;
+		for(int32_t nx = entry.startX; nx <= entry.endX; nx += FLOOR_SIZE)
+		{
+			if(leafE)
+			{
+				if((onlyPlayers ? leafE->m_lastPlayerChange : leafE->m_lastChange) > entry.sequence)
+					return false;
+
+				leafE = leafE->stepEast();
+			}
+			else
+				leafE = getLeaf(nx + FLOOR_SIZE, ny);
+		}
+
+		if(leafS)
+			leafS = leafS->stepSouth();
+		else
+			leafS = getLeaf(entry.startX, ny + FLOOR_SIZE);
 	}
-	else if(centerPos.z == 7)
+
+	entry.sequence = sequence;
+	return true;
+}
+
+void Map::releaseTaskCaches()
+{
+	sightCache.clear();
+
+	SpectatorCache* caches[] = {&spectatorCache, &playerSpectatorCache};
+	for(uint32_t i = 0; i < 2; ++i)
 	{
-		minRangeZ = 0;
-		maxRangeZ = 9;
+		if(caches[i]->size() <= SPECTATOR_CACHE_SIZE)
+			continue;
+
+		for(SpectatorCache::iterator it = caches[i]->begin(); it != caches[i]->end(); ++it)
+			retiredSpectators.push_back(it->second.list);
+
+		caches[i]->clear();
 	}
-	else
+
+	for(std::vector<std::shared_ptr<SpectatorVec> >::iterator it = retiredSpectators.begin(); it != retiredSpectators.end(); ++it)
 	{
-		minRangeZ = 0;
-		maxRangeZ = 7;
+		if(spectatorPool.size() >= SPECTATOR_POOL_SIZE || it->use_count() > 1)
+			continue;
+
+		(*it)->clear();
+		spectatorPool.push_back(*it);
 	}
 
-	getSpectatorsInternal(list, centerPos, false, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ);
-	return list;
+	retiredSpectators.clear();
 }
 
 bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool checkLineOfSight /*= true*/,
@@ -543,12 +740,11 @@ bool Map::checkSightLine(const Position& fromPos, const Position& toPos) const
 
 		if(lastrz != rz || ((toPos.x != rx || toPos.y != ry || toPos.z != rz) && (fromPos.x != rx || fromPos.y != ry || fromPos.z != rz)))
 		{
-			if(lastrz != rz && const_cast<Map*>(this)->getTile(lastrx, lastry, std::min(lastrz, rz)))
+			if(lastrz != rz && hasTileBit(lastrx, lastry, std::min(lastrz, rz), TILEBIT_TILE))
 				return false;
 
 			lastrx = rx; lastry = ry; lastrz = rz;
-			const Tile* tile = const_cast<Map*>(this)->getTile(rx, ry, rz);
-			if(tile && tile->hasProperty(BLOCKPROJECTILE))
+			if(hasTileBit(rx, ry, rz, TILEBIT_BLOCKPROJECTILE))
 				return false;
 		}
 
@@ -575,8 +771,35 @@ bool Map::isSightClear(const Position& fromPos, const Position& toPos, bool floo
 	if(floorCheck && fromPos.z != toPos.z)
 		return false;
 
+	if(sightSequence != Floor::sightChanges)
+	{
+		sightCache.clear();
+		sightSequence = Floor::sightChanges;
+	}
+
+	uint64_t from = ((uint64_t)fromPos.x << 24) | ((uint64_t)fromPos.y << 8) | fromPos.z,
+		to = ((uint64_t)toPos.x << 24) | ((uint64_t)toPos.y << 8) | toPos.z;
+	std::pair<SightCache::iterator, bool> result = sightCache.insert(std::make_pair(
+		std::make_pair(std::min(from, to), std::max(from, to)), false));
+	if(!result.second)
+		return result.first->second;
+
 	// Cast two converging rays and see if either yields a result.
-	return checkSightLine(fromPos, toPos) || checkSightLine(toPos, fromPos);
+	result.first->second = checkSightLine(fromPos, toPos) || checkSightLine(toPos, fromPos);
+	return result.first->second;
+}
+
+bool Map::hasTileBit(int32_t x, int32_t y, int32_t z, tilebit_t bit) const
+{
+	if(x < 0 || y < 0 || x > 0xFFFF || y > 0xFFFF || z < 0 || z >= MAP_MAX_LAYERS)
+		return false;
+
+	QTreeLeafNode* leaf = const_cast<Map*>(this)->getLeaf(x, y);
+	if(!leaf)
+		return false;
+
+	const Floor* floor = leaf->getFloor(z);
+	return floor && ((floor->bits[bit] >> (((y & FLOOR_MASK) << FLOOR_BITS) | (x & FLOOR_MASK))) & 1);
 }
 
 const Tile* Map::canWalkTo(const Creature* creature, const Position& pos)
@@ -600,8 +823,76 @@ const Tile* Map::canWalkTo(const Creature* creature, const Position& pos)
 	return tile;
 }
 
+void Map::getPathStates(int32_t x, int32_t y, int32_t z, int32_t count, uint8_t* states, const Creature* creature)
+{
+	uint8_t freeState = (Tile::isLeavingHardcoreZone(creature) ? PATHSTATE_CHECK : PATHSTATE_FREE);
+	Floor* floor = NULL;
+	for(int32_t end = x + count; x < end; )
+	{
+		int32_t offsetX = (x & FLOOR_MASK), width = std::min(end - x, FLOOR_SIZE - offsetX);
+		if(x < 0 || y < 0 || x > 0xFFFF || y > 0xFFFF)
+		{
+			//one tile at a time until the row is back on the map
+			width = 1;
+			floor = NULL;
+		}
+		else if(QTreeLeafNode* leaf = getLeaf(x, y))
+			floor = leaf->getFloor(z);
+		else
+			floor = NULL;
+
+		if(!floor)
+		{
+			//there are no tiles here at all, leave those to the caller
+			std::fill(states, states + width, (uint8_t)PATHSTATE_CHECK);
+			states += width;
+			x += width;
+			continue;
+		}
+
+		uint32_t shift = (y & FLOOR_MASK) << FLOOR_BITS;
+		uint8_t freeRow = floor->getFreeBits() >> shift, blockedRow = floor->getBlockedBits() >> shift;
+		for(int32_t i = offsetX; i < offsetX + width; ++i)
+		{
+			if((freeRow >> i) & 1)
+				*states++ = freeState;
+			else if((blockedRow >> i) & 1)
+				*states++ = PATHSTATE_BLOCKED;
+			else
+				*states++ = PATHSTATE_CHECK;
+		}
+
+		x += width;
+	}
+}
+
+uint32_t Map::getTileBits(int32_t x, int32_t y, int32_t z, int32_t count, tilebit_t bit)
+{
+	uint32_t result = 0;
+	for(int32_t i = 0; i < count; )
+	{
+		int32_t offsetX = ((x + i) & FLOOR_MASK), width = std::min(count - i, FLOOR_SIZE - offsetX);
+		if(x + i < 0 || y < 0 || x + i > 0xFFFF || y > 0xFFFF)
+		{
+			++i;
+			continue;
+		}
+
+		QTreeLeafNode* leaf = getLeaf(x + i, y);
+		if(Floor* floor = (leaf ? leaf->getFloor(z) : NULL))
+		{
+			uint32_t row = (uint8_t)(floor->bits[bit] >> ((y & FLOOR_MASK) << FLOOR_BITS));
+			result |= ((row >> offsetX) & ((1U << width) - 1)) << i;
+		}
+
+		i += width;
+	}
+
+	return result;
+}
+
 bool Map::getPathTo(const Creature* creature, const Position& destPos,
-	std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/)
+	std::list<Direction>& listDir, int32_t maxSearchDist /*= -1*/, uint32_t maxNodes /*= MAX_NODES*/)
 {
 	if(!canWalkTo(creature, destPos))
 		return false;
@@ -613,7 +904,7 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 	if(startPos.z != endPos.z)
 		return false;
 
-	AStarNodes nodes;
+	AStarNodes nodes(maxNodes);
 	AStarNode* startNode = nodes.createOpenNode();
 
 	startNode->x = startPos.x;
@@ -624,6 +915,7 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 
 	startNode->f = startNode->g + startNode->h;
 	startNode->parent = NULL;
+	nodes.openNode(startNode);
 
 	Position pos;
 	pos.z = startPos.z;
@@ -682,8 +974,6 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 				{
 					if(neighbourNode->g <= newg) //The node on the closed/open list is cheaper than this one
 						continue;
-
-					nodes.openNode(neighbourNode);
 				}
 				else if(!(neighbourNode = nodes.createOpenNode())) //Does not exist in the open/closed list, create a new node
 				{
@@ -701,6 +991,7 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 
 				neighbourNode->f = neighbourNode->g + neighbourNode->h;
 				neighbourNode->parent = n;
+				nodes.openNode(neighbourNode);
 			}
 		}
 
@@ -741,13 +1032,34 @@ bool Map::getPathTo(const Creature* creature, const Position& destPos,
 	return !listDir.empty();
 }
 
-bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirList,
+// walkability straight from the map, only valid on the dispatcher
+class MapWalkSource
+{
+	public:
+		MapWalkSource(Map* map, const Creature* creature): m_map(map), m_creature(creature) {}
+
+		bool canWalk(const Position& pos, int32_t& extraCost) const
+		{
+			const Tile* tile = m_map->canWalkTo(m_creature, pos);
+			if(!tile)
+				return false;
+
+			extraCost = AStarNodes::getTileWalkCost(m_creature, tile);
+			return true;
+		}
+
+	protected:
+		Map* m_map;
+		const Creature* m_creature;
+};
+
+template<class WalkSource>
+static bool findPathMatching(const WalkSource& source, const Position& startPos, std::list<Direction>& dirList,
 	const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
 {
-	Position startPos = creature->getPosition();
 	Position endPos;
 
-	AStarNodes nodes;
+	AStarNodes nodes(fpp.maxNodes);
 	AStarNode* startNode = nodes.createOpenNode();
 
 	startNode->x = startPos.x;
@@ -755,6 +1067,7 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 
 	startNode->f = 0;
 	startNode->parent = NULL;
+	nodes.openNode(startNode);
 
 	dirList.clear();
 	int32_t bestMatch = 0;
@@ -778,7 +1091,7 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 	AStarNode* found = NULL;
 	AStarNode* n = NULL;
 
-	const Tile* tile = NULL;
+	int32_t extraCost = 0;
 	while(fpp.maxSearchDist != -1 || nodes.countClosedNodes() < 100)
 	{
 		if(!(n = nodes.getBestNode()))
@@ -815,11 +1128,10 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 					inRange = false;
 			}
 
-			if(inRange && (tile = canWalkTo(creature, pos)))
+			if(inRange && source.canWalk(pos, extraCost))
 			{
 				//The cost (g) for this neighbour
-				int32_t cost = nodes.getMapWalkCost(creature, n, tile, pos),
-					extraCost = nodes.getTileWalkCost(creature, tile),
+				int32_t cost = nodes.getMapWalkCost(NULL, n, NULL, pos),
 					newf = n->f + cost + extraCost;
 
 				//Check if the node is already in the closed/open list
@@ -829,8 +1141,6 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 				{
 					if(neighbourNode->f <= newf) //The node on the closed/open list is cheaper than this one
 						continue;
-
-					nodes.openNode(neighbourNode);
 				}
 				else if(!(neighbourNode = nodes.createOpenNode())) //Does not exist in the open/closed list, create a new node
 				{
@@ -848,6 +1158,7 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 
 				neighbourNode->parent = n;
 				neighbourNode->f = newf;
+				nodes.openNode(neighbourNode);
 			}
 		}
 
@@ -892,259 +1203,231 @@ bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirLis
 	return true;
 }
 
-//*********** AStarNodes *************
-
-AStarNodes::AStarNodes()
+bool Map::getPathMatching(const Creature* creature, std::list<Direction>& dirList,
+	const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp)
 {
-	curNode = 0;
-	openNodes.reset();
+	return findPathMatching(MapWalkSource(this, creature), creature->getPosition(), dirList, pathCondition, fpp);
 }
 
-AStarNode* AStarNodes::createOpenNode()
+bool Map::getPathMatching(const PathSnapshot& snapshot, std::list<Direction>& dirList)
 {
-	if(curNode >= MAX_NODES)
-		return NULL;
-
-	uint32_t retNode = curNode;
-	curNode++;
-
-	openNodes[retNode] = 1;
-	return &nodes[retNode];
+	return findPathMatching(snapshot, snapshot.getStartPos(), dirList,
+		FrozenPathingConditionCall(snapshot), snapshot.getParams());
 }
 
-AStarNode* AStarNodes::getBestNode()
+bool Map::getPathByFlowField(const Creature* creature, const Creature* target,
+	std::list<Direction>& dirList, const FindPathParams& fpp)
 {
-	if(!curNode)
-		return NULL;
+	//fleeing and distance keeping monsters want a spot away from the target
+	if(!creature->getMonster() || fpp.keepDistance || fpp.maxTargetDist != 1
+		|| !g_config.getBool(ConfigManager::PATHFINDING_FLOW_FIELDS))
+		return false;
 
-	int32_t bestNodeF = 100000;
-	uint32_t bestNode = 0;
+	const Position& targetPos = target->getPosition();
+	if(targetPos.z != creature->getPosition().z)
+		return false;
 
-	bool found = false;
-	for(uint32_t i = 0; i < curNode; i++)
+	int64_t now = OTSYS_TIME();
+	FlowFieldMap::iterator it = flowFields.find(target->getID());
+	if(it == flowFields.end() || it->second->getTargetPos() != targetPos
+		|| now - it->second->getCreated() > FLOW_FIELD_LIFETIME)
 	{
-		if(nodes[i].f < bestNodeF && openNodes[i] == 1)
+		//the target moved, drop its field along with every stale one
+		for(it = flowFields.begin(); it != flowFields.end(); )
 		{
-			found = true;
-			bestNodeF = nodes[i].f;
-			bestNode = i;
+			if(it->first == target->getID() || now - it->second->getCreated() > FLOW_FIELD_LIFETIME)
+				flowFields.erase(it++);
+			else
+				++it;
 		}
-	}
 
-	if(found)
-		return &nodes[bestNode];
-
-	return NULL;
-}
+		it = flowFields.insert(std::make_pair(target->getID(), shared_ptr<FlowField>(new FlowField(targetPos)))).first;
+		++flowFieldStats.built;
+	}
 
-void AStarNodes::closeNode(AStarNode* node)
-{
-	uint32_t pos = GET_NODE_INDEX(node);
-	if(pos < MAX_NODES)
+	if(!it->second->getPath(creature, FrozenPathingConditionCall(targetPos), fpp, dirList))
 	{
-		openNodes[pos] = 0;
-		return;
+		++flowFieldStats.fallbacks;
+		return false;
 	}
 
-	assert(pos >= MAX_NODES);
-	std::clog << "AStarNodes. trying to close node out of range" << std::endl;
-	return;
+	++flowFieldStats.paths;
+	return true;
 }
 
-void AStarNodes::openNode(AStarNode* node)
+//*********** AStarNodes *************
+
+int32_t AStarNodes::getTileWalkCost(const Creature* creature, const Tile* tile)
 {
-	uint32_t pos = GET_NODE_INDEX(node);
-	if(pos < MAX_NODES)
+	int32_t cost = 0;
+	if(tile->getTopVisibleCreature(creature)) //destroy creature cost
+		cost += MAP_NORMALWALKCOST * 3;
+
+	if(const MagicField* field = tile->getFieldItem())
 	{
-		openNodes[pos] = 1;
-		return;
+		if(!creature->isImmune(field->getCombatType()))
+			cost += MAP_NORMALWALKCOST * 3;
 	}
 
-	assert(pos >= MAX_NODES);
-	std::clog << "AStarNodes. trying to open node out of range" << std::endl;
-	return;
+	return cost;
 }
 
-uint32_t AStarNodes::countClosedNodes()
-{
-	uint32_t counter = 0;
-	for(uint32_t i = 0; i < curNode; i++)
-	{
-		if(!openNodes[i])
-			counter++;
-	}
+//*********** Floor constructor **************
 
-	return counter;
-}
+uint64_t Floor::sightChanges = 0;
+uint32_t Floor::itemTilesOutsideHouses = 0;
+uint32_t Floor::itemTilesOutsidePz = 0;
 
-uint32_t AStarNodes::countOpenNodes()
+Floor::Floor()
 {
-	uint32_t counter = 0;
-	for(uint32_t i = 0; i < curNode; i++)
+	for(int32_t i = 0; i < FLOOR_SIZE; ++i)
 	{
-		if(openNodes[i] == 1)
-			counter++;
+		for(int32_t j = 0; j < FLOOR_SIZE; ++j)
+			tiles[i][j] = 0;
 	}
 
-	return counter;
+	for(int32_t i = 0; i < TILEBIT_LAST; ++i)
+		bits[i] = 0;
 }
 
-bool AStarNodes::isInList(uint16_t x, uint16_t y)
+void Floor::updateBits(uint32_t x, uint32_t y, const Tile* tile)
 {
-	for(uint32_t i = 0; i < curNode; i++)
+	uint64_t mask = (uint64_t)1 << ((y << FLOOR_BITS) | x);
+	bool hadTile = (bits[TILEBIT_TILE] & mask), blocked = (bits[TILEBIT_BLOCKPROJECTILE] & mask);
+	if(hadTile != (tile != NULL) || blocked != (tile && tile->hasFlag(TILESTATE_BLOCKPROJECTILE)))
+		++sightChanges;
+
+	if(bits[TILEBIT_ITEMS] & mask)
 	{
-		if(nodes[i].x == x && nodes[i].y == y)
-			return true;
+		if(!(bits[TILEBIT_HOUSE] & mask))
+			--itemTilesOutsideHouses;
+
+		if(!(bits[TILEBIT_PROTECTIONZONE] & mask))
+			--itemTilesOutsidePz;
 	}
 
-	return false;
-}
+	for(int32_t i = 0; i < TILEBIT_LAST; ++i)
+		bits[i] &= ~mask;
 
-AStarNode* AStarNodes::getNodeInList(uint16_t x, uint16_t y)
-{
-	for(uint32_t i = 0; i < curNode; i++)
+	if(!tile)
+		return;
+
+	if(tile->getItemList())
 	{
-		if(nodes[i].x == x && nodes[i].y == y)
-			return &nodes[i];
+		bits[TILEBIT_ITEMS] |= mask;
+		if(!tile->hasFlag(TILESTATE_HOUSE))
+			++itemTilesOutsideHouses;
+
+		if(!tile->hasFlag(TILESTATE_PROTECTIONZONE))
+			++itemTilesOutsidePz;
 	}
 
-	return NULL;
-}
+	bits[TILEBIT_TILE] |= mask;
+	if(tile->hasFlag(TILESTATE_BLOCKPROJECTILE))
+		bits[TILEBIT_BLOCKPROJECTILE] |= mask;
 
-int32_t AStarNodes::getMapWalkCost(const Creature*, AStarNode* node,
-	const Tile*, const Position& neighbourPos)
-{
-	if(std::abs(node->x - neighbourPos.x) == std::abs(node->y - neighbourPos.y)) //diagonal movement extra cost
-		return MAP_DIAGONALWALKCOST;
+	if(tile->ground)
+		bits[TILEBIT_GROUND] |= mask;
 
-	return MAP_NORMALWALKCOST;
-}
+	if(tile->hasFlag(TILESTATE_BLOCKSOLID) || tile->hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID))
+		bits[TILEBIT_BLOCKSOLID] |= mask;
 
-int32_t AStarNodes::getTileWalkCost(const Creature* creature, const Tile* tile)
-{
-	int32_t cost = 0;
-	if(tile->getTopVisibleCreature(creature)) //destroy creature cost
-		cost += MAP_NORMALWALKCOST * 3;
+	if(tile->hasFlag(TILESTATE_BLOCKPATH) || tile->hasFlag(TILESTATE_IMMOVABLEBLOCKPATH)
+		|| tile->hasFlag(TILESTATE_NOFIELDBLOCKPATH) || tile->hasFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH))
+		bits[TILEBIT_BLOCKPATH] |= mask;
 
-	if(const MagicField* field = tile->getFieldItem())
-	{
-		if(!creature->isImmune(field->getCombatType()))
-			cost += MAP_NORMALWALKCOST * 3;
-	}
+	if(tile->floorChange() || tile->positionChange())
+		bits[TILEBIT_FLOORCHANGE] |= mask;
 
-	return cost;
-}
+	if(tile->hasFlag(TILESTATE_PROTECTIONZONE))
+		bits[TILEBIT_PROTECTIONZONE] |= mask;
 
-int32_t AStarNodes::getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal)
-{
-	int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
-	return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(
-		x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
-}
+	if(tile->hasFlag(TILESTATE_HOUSE))
+		bits[TILEBIT_HOUSE] |= mask;
 
-//*********** Floor constructor **************
+	if(tile->hasFlag(TILESTATE_MAGICFIELD))
+		bits[TILEBIT_MAGICFIELD] |= mask;
 
-Floor::Floor()
-{
-	for(int32_t i = 0; i < FLOOR_SIZE; ++i)
-	{
-		for(int32_t j = 0; j < FLOOR_SIZE; ++j)
-			tiles[i][j] = 0;
-	}
+	if(tile->hasFlag(TILESTATE_OPTIONALZONE) || tile->hasFlag(TILESTATE_HARDCOREZONE)
+		|| tile->hasFlag(TILESTATE_NOLOGOUT))
+		bits[TILEBIT_ZONE] |= mask;
+
+	const CreatureVector* creatures = tile->getCreatures();
+	if(creatures && !creatures->empty())
+		bits[TILEBIT_CREATURE] |= mask;
 }
 
-//**************** QTreeNode **********************
-QTreeNode::QTreeNode()
+uint64_t Floor::getFreeBits() const
 {
-	m_isLeaf = false;
-	for(int32_t i = 0; i < 4; ++i)
-		m_child[i] = NULL;
+	return bits[TILEBIT_GROUND] & ~(bits[TILEBIT_BLOCKSOLID] | bits[TILEBIT_BLOCKPATH] | bits[TILEBIT_FLOORCHANGE]
+		| bits[TILEBIT_PROTECTIONZONE] | bits[TILEBIT_HOUSE] | bits[TILEBIT_MAGICFIELD] | bits[TILEBIT_ZONE]
+		| bits[TILEBIT_CREATURE]);
 }
 
-QTreeNode::~QTreeNode()
+uint64_t Floor::getBlockedBits() const
 {
-	for(int32_t i = 0; i < 4; ++i)
-		delete m_child[i];
+	//a missing tile is not blocked, it is left for the caller to handle
+	return (bits[TILEBIT_TILE] & ~bits[TILEBIT_GROUND]) | bits[TILEBIT_FLOORCHANGE];
 }
 
-QTreeLeafNode* QTreeNode::getLeaf(uint16_t x, uint16_t y)
+PathState_t Floor::getPathState(uint32_t x, uint32_t y) const
 {
-	if(isLeaf())
-		return static_cast<QTreeLeafNode*>(this);
+	uint32_t bit = (y << FLOOR_BITS) | x;
+	if((getFreeBits() >> bit) & 1)
+		return PATHSTATE_FREE;
 
-	uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
-	if(m_child[index])
-		return m_child[index]->getLeaf(x * 2, y * 2);
+	if((getBlockedBits() >> bit) & 1)
+		return PATHSTATE_BLOCKED;
 
-	return NULL;
+	return PATHSTATE_CHECK;
 }
 
-QTreeLeafNode* QTreeNode::getLeafStatic(QTreeNode* root, uint16_t x, uint16_t y)
+//************ LeafNode  ************************
+void QTreeLeafNode::addCreature(Creature* c)
 {
-	QTreeNode* currentNode = root;
-	uint32_t currentX = x, currentY = y;
-	while(currentNode)
-	{
-		if(currentNode->isLeaf())
-			return static_cast<QTreeLeafNode*>(currentNode);
+	creatureList.push_back(c);
+	if(c->getPlayer())
+		playerList.push_back(c);
 
-		uint32_t index = ((currentX & 0x8000) >> 15) | ((currentY & 0x8000) >> 14);
-		if(!currentNode->m_child[index])
-			return NULL;
-
-		currentNode = currentNode->m_child[index];
-		currentX = currentX * 2;
-		currentY = currentY * 2;
-	}
-
-	return NULL;
+	onCreatureChange(c);
 }
 
-QTreeLeafNode* QTreeNode::createLeaf(uint16_t x, uint16_t y, uint16_t level)
+void QTreeLeafNode::removeCreature(Creature* c)
 {
-	if(!isLeaf())
+	CreatureVector::iterator it = std::find(creatureList.begin(), creatureList.end(), c);
+	assert(it != creatureList.end());
+	creatureList.erase(it);
+	if(c->getPlayer())
 	{
-		uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
-		if(!m_child[index])
-		{
-			if(level != FLOOR_BITS)
-				m_child[index] = new QTreeNode();
-			else
-			{
-				m_child[index] = new QTreeLeafNode();
-				QTreeLeafNode::newLeaf = true;
-			}
-		}
-
-		return m_child[index]->createLeaf(x * 2, y * 2, level - 1);
+		it = std::find(playerList.begin(), playerList.end(), c);
+		assert(it != playerList.end());
+		playerList.erase(it);
 	}
 
-	return static_cast<QTreeLeafNode*>(this);
-}
-
-
-//************ LeafNode  ************************
-bool QTreeLeafNode::newLeaf = false;
-QTreeLeafNode::QTreeLeafNode()
-{
-	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
-		m_array[i] = NULL;
-
-	m_isLeaf = true;
-	m_leafS = NULL;
-	m_leafE = NULL;
+	onCreatureChange(c);
 }
 
-QTreeLeafNode::~QTreeLeafNode()
+void QTreeLeafNode::onCreatureChange(const Creature* c)
 {
-	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
-		delete m_array[i];
+	m_lastChange = ++changeSequence;
+	if(c->getPlayer())
+		m_lastPlayerChange = m_lastChange;
 }
 
-Floor* QTreeLeafNode::createFloor(uint16_t z)
+void QTreeLeafNode::resetTileDescriptions()
 {
-	if(!m_array[z])
-		m_array[z] = new Floor();
+	for(int32_t z = 0; z < MAP_MAX_LAYERS; ++z)
+	{
+		if(!m_array[z])
+			continue;
 
-	return m_array[z];
+		for(int32_t x = 0; x < FLOOR_SIZE; ++x)
+		{
+			for(int32_t y = 0; y < FLOOR_SIZE; ++y)
+			{
+				if(Tile* tile = m_array[z]->tiles[x][y])
+					tile->resetDescription();
+			}
+		}
+	}
 }
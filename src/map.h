@@ -42,29 +42,54 @@ struct AStarNode
 using std::shared_ptr;
 #define MAP_MAX_LAYERS 16
 
+// default node budget of a single search, see FindPathParams::maxNodes
 #define MAX_NODES 512
-#define GET_NODE_INDEX(a) (a - &nodes[0])
 
 #define MAP_NORMALWALKCOST 10
 #define MAP_DIAGONALWALKCOST 25
 
+// Node storage reused by every search on the same thread
+struct AStarArena
+{
+	struct Slot
+	{
+		uint32_t key, node, stamp;
+	};
+
+	AStarArena(): tableShift(32), stamp(0), inUse(false) {}
+	void prepare(uint32_t maxNodes);
+
+	std::vector<AStarNode> nodes;
+	// position of every node in the open heap, -1 once closed and -2 before it was ever opened
+	std::vector<int32_t> heapIndex;
+	// open nodes as indexes into nodes, ordered by f and then creation order
+	std::vector<uint32_t> heap;
+	// open addressed position -> node table, slots of older searches are stale by stamp
+	std::vector<Slot> table;
+
+	uint32_t tableShift, stamp;
+	bool inUse;
+};
+
 class AStarNodes
 {
 	public:
-		AStarNodes();
-		virtual ~AStarNodes() {}
+		AStarNodes(uint32_t maxNodes = MAX_NODES);
+		virtual ~AStarNodes();
 
+		// nodes are filled by the caller after createOpenNode, then passed
+		// to openNode, which is also used when a cheaper way is found later
 		void openNode(AStarNode* node);
 		void closeNode(AStarNode* node);
 
-		uint32_t countOpenNodes();
-		uint32_t countClosedNodes();
+		uint32_t countOpenNodes() const {return m_arena->heap.size();}
+		uint32_t countClosedNodes() const {return m_count - m_arena->heap.size();}
 
 		AStarNode* getBestNode();
 		AStarNode* createOpenNode();
 		AStarNode* getNodeInList(uint16_t x, uint16_t y);
 
-		bool isInList(uint16_t x, uint16_t y);
+		bool isInList(uint16_t x, uint16_t y) {return getNodeInList(x, y) != NULL;}
 		int32_t getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal);
 
 		int32_t getMapWalkCost(const Creature* creature, AStarNode* node,
@@ -72,25 +97,104 @@ class AStarNodes
 		static int32_t getTileWalkCost(const Creature* creature, const Tile* tile);
 
 	private:
-		AStarNode nodes[MAX_NODES];
+		uint32_t getIndex(const AStarNode* node) const {return node - &m_arena->nodes[0];}
+		bool isBetter(uint32_t a, uint32_t b) const;
+
+		void siftUp(uint32_t pos);
+		void siftDown(uint32_t pos);
+		void setHeap(uint32_t pos, uint32_t node);
 
-		std::bitset<MAX_NODES> openNodes;
-		uint32_t curNode;
+		AStarArena* m_arena;
+		AStarArena m_localArena;
+
+		uint32_t m_count, m_maxNodes;
+		static thread_local AStarArena m_threadArena;
 };
 
 #define FLOOR_BITS 3
 #define FLOOR_SIZE (1 << FLOOR_BITS)
 #define FLOOR_MASK (FLOOR_SIZE - 1)
 
+enum tilebit_t
+{
+	TILEBIT_GROUND = 0,
+	TILEBIT_BLOCKSOLID,
+	TILEBIT_BLOCKPATH,
+	TILEBIT_FLOORCHANGE, // teleports too
+	TILEBIT_PROTECTIONZONE,
+	TILEBIT_HOUSE,
+	TILEBIT_MAGICFIELD,
+	TILEBIT_ZONE, // optional, hardcore and no logout
+	TILEBIT_CREATURE,
+	TILEBIT_TILE, // the tile exists at all
+	TILEBIT_BLOCKPROJECTILE,
+	TILEBIT_ITEMS, // the tile has an item list, even an empty one
+	TILEBIT_LAST
+};
+
 struct Floor
 {
 	Floor();
 	Tile* tiles[FLOOR_SIZE][FLOOR_SIZE];
+	// one layer per tilebit_t, bit (y * FLOOR_SIZE + x) so a row is a byte
+	uint64_t bits[TILEBIT_LAST];
+
+	void updateBits(uint32_t x, uint32_t y, const Tile* tile);
+
+	// tiles that are PATHSTATE_FREE and PATHSTATE_BLOCKED, in the same layout
+	uint64_t getFreeBits() const;
+	uint64_t getBlockedBits() const;
+	PathState_t getPathState(uint32_t x, uint32_t y) const;
+
+	// bumped whenever a tile or projectile bit changes on any floor
+	static uint64_t sightChanges;
+	// tiles with an item list outside houses and outside protection zones, the
+	// tile counts a full map clean reports
+	static uint32_t itemTilesOutsideHouses, itemTilesOutsidePz;
+};
+
+// isSightClear results by (lower, higher) packed position, sight is symmetric
+struct SightHash
+{
+	size_t operator()(const std::pair<uint64_t, uint64_t>& key) const
+		{return (size_t)(key.first * 0x9E3779B97F4A7C15ULL ^ key.second);}
 };
+typedef std::unordered_map<std::pair<uint64_t, uint64_t>, bool, SightHash> SightCache;
 
 class FrozenPathingConditionCall;
+class PathSnapshot;
+class FlowField;
 class QTreeLeafNode;
 
+#define SPECTATOR_CACHE_SIZE 4096
+#define SPECTATOR_POOL_SIZE 256
+
+struct SpectatorCacheEntry
+{
+	std::shared_ptr<SpectatorVec> list;
+	// leaf-aligned area that was scanned, the list stays valid until any
+	// leaf in it changes after the recorded sequence
+	int32_t startX, startY, endX, endY;
+	uint64_t sequence;
+};
+typedef std::map<Position, SpectatorCacheEntry> SpectatorCache;
+
+// flow fields older than this are rebuilt even if their target did not move
+#define FLOW_FIELD_LIFETIME 1000
+
+struct FlowFieldStats
+{
+	FlowFieldStats(): built(0), paths(0), fallbacks(0) {}
+	uint64_t built, paths, fallbacks;
+};
+typedef std::map<uint32_t, shared_ptr<FlowField> > FlowFieldMap;
+
+struct RegionStats
+{
+	RegionStats(): activated(0), suspended(0), woken(0) {}
+	uint64_t activated, suspended, woken;
+};
+
 class QTreeNode
 {
 	public:
@@ -127,19 +231,71 @@ class QTreeLeafNode : public QTreeNode
 		void addCreature(Creature* c);
 		void removeCreature(Creature* c);
 
+		// called whenever a creature enters, leaves or moves within this leaf
+		void onCreatureChange(const Creature* c);
+		static uint64_t getChangeSequence() {return changeSequence;}
+
+		// frees the cached item bytes of every tile in this leaf
+		void resetTileDescriptions();
+
 	protected:
 		static bool newLeaf;
+		static uint64_t changeSequence;
+		uint64_t m_lastChange, m_lastPlayerChange;
+		// players whose activation radius covers this leaf
+		uint32_t m_activePlayers;
 
 		QTreeLeafNode* m_leafS;
 		QTreeLeafNode* m_leafE;
 
 		Floor* m_array[MAP_MAX_LAYERS];
 		CreatureVector creatureList;
+		// players only, a subset of creatureList
+		CreatureVector playerList;
 
 		friend class Map;
+		friend class MapGrid;
 		friend class QTreeNode;
 };
 
+#ifdef __FLAT_MAP_GRID__
+// leaves per chunk side, a chunk covers 256x256 tiles
+#define MAP_GRID_CHUNK_BITS 5
+#define MAP_GRID_CHUNK_SIZE (1 << MAP_GRID_CHUNK_BITS)
+#define MAP_GRID_CHUNK_MASK (MAP_GRID_CHUNK_SIZE - 1)
+#define MAP_GRID_CHUNK_SHIFT (FLOOR_BITS + MAP_GRID_CHUNK_BITS)
+#define MAP_GRID_SIZE (0x10000 >> MAP_GRID_CHUNK_SHIFT)
+
+// Flat, chunk paged replacement of the QTreeNode lookup. Leaves are found
+// with two array lookups, chunks are only allocated for populated areas.
+class MapGrid
+{
+	public:
+		MapGrid(): m_chunks(MAP_GRID_SIZE * MAP_GRID_SIZE, (Chunk*)NULL) {}
+		virtual ~MapGrid();
+
+		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) const
+		{
+			const Chunk* chunk = m_chunks[(y >> MAP_GRID_CHUNK_SHIFT) * MAP_GRID_SIZE + (x >> MAP_GRID_CHUNK_SHIFT)];
+			if(!chunk)
+				return NULL;
+
+			return chunk->leaves[(y >> FLOOR_BITS) & MAP_GRID_CHUNK_MASK][(x >> FLOOR_BITS) & MAP_GRID_CHUNK_MASK];
+		}
+
+		QTreeLeafNode* createLeaf(uint16_t x, uint16_t y);
+
+	protected:
+		struct Chunk
+		{
+			// row major, so stepping east stays within the same cache lines
+			QTreeLeafNode* leaves[MAP_GRID_CHUNK_SIZE][MAP_GRID_CHUNK_SIZE];
+		};
+
+		std::vector<Chunk*> m_chunks;
+};
+#endif
+
 /**
   * Map class.
   * Holds all the actual map-data
@@ -197,6 +353,17 @@ class Map
 		* \param c Creature pointer to the creature to remove
 		*/
 		bool removeCreature(Creature* c);
+		// keeps the region activation of players up to date and wakes creatures
+		// carried into an active region, call after the leaf of c changed
+		void onCreatureChangeLeaf(Creature* c, const Position& oldPos, const Position& newPos);
+
+		/**
+		* Checks if a creature at pos should be scheduled, that is whether any
+		* player is within regionActivationRadius (rounded to whole leaves)
+		*/
+		bool isRegionActive(const Position& pos);
+		bool isRegionActive(const Creature* creature) const;
+		const RegionStats& getRegionStats() const {return regionStats;}
 
 		/**
 		* Checks if you can throw an object to that position
@@ -220,6 +387,7 @@ class Map
 		*/
 		bool isSightClear(const Position& fromPos, const Position& toPos, bool floorCheck) const;
 		bool checkSightLine(const Position& fromPos, const Position& toPos) const;
+		bool hasTileBit(int32_t x, int32_t y, int32_t z, tilebit_t bit) const;
 
 		/**
 		* Get the path to a specific position on the map.
@@ -227,53 +395,88 @@ class Map
 		* \param destPos The position we want a path calculated to
 		* \param listDir contains a list of directions to the destination
 		* \param maxDist Maximum distance from our current position to search, default: -1 (no limit)
+		* \param maxNodes Maximum amount of nodes the search may create, default: MAX_NODES
 		* \returns returns true if a path was found
 		*/
 		bool getPathTo(const Creature* creature, const Position& destPos,
-			std::list<Direction>& listDir, int32_t maxDist = -1);
+			std::list<Direction>& listDir, int32_t maxDist = -1, uint32_t maxNodes = MAX_NODES);
 		bool getPathMatching(const Creature* creature, std::list<Direction>& dirList,
 			const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp);
-
+		// same search against a snapshot, safe to call outside the dispatcher
+		static bool getPathMatching(const PathSnapshot& snapshot, std::list<Direction>& dirList);
+		// path of a monster chasing target along the flow field shared by all its
+		// chasers, false when the field does not apply and a search is needed
+		bool getPathByFlowField(const Creature* creature, const Creature* target,
+			std::list<Direction>& dirList, const FindPathParams& fpp);
+		const FlowFieldStats& getFlowFieldStats() const {return flowFieldStats;}
+
+#ifdef __FLAT_MAP_GRID__
+		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) {return grid.getLeaf(x, y);}
+#else
 		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) {return root.getLeaf(x, y);}
+#endif
 		const Tile* canWalkTo(const Creature* creature, const Position& pos);
+		// PathState_t of count tiles from x eastwards for creature, read a floor row at a time
+		void getPathStates(int32_t x, int32_t y, int32_t z, int32_t count, uint8_t* states, const Creature* creature);
+		// bit i is set when the tile at x + i has bit set in its layer, count is up to 32
+		uint32_t getTileBits(int32_t x, int32_t y, int32_t z, int32_t count, tilebit_t bit);
 		Waypoints waypoints;
 
 	protected:
+#ifdef __FLAT_MAP_GRID__
+		MapGrid grid;
+#else
 		QTreeNode root;
+#endif
 
 		uint32_t mapWidth, mapHeight;
 		std::string spawnfile, housefile;
 		StringVec descriptions;
 
-		SpectatorCache spectatorCache;
-		void clearSpectatorCache() {spectatorCache.clear();}
+		SpectatorCache spectatorCache, playerSpectatorCache;
+		// lists replaced during the current task (callers may still iterate them)
+		// and cleared lists ready for reuse
+		std::vector<std::shared_ptr<SpectatorVec> > retiredSpectators, spectatorPool;
+
+		// by target creature id
+		FlowFieldMap flowFields;
+		FlowFieldStats flowFieldStats;
+
+		// remembered sight lines, dropped after every task or when a tile changes
+		mutable SightCache sightCache;
+		mutable uint64_t sightSequence;
+
+		// in leaves, 0 keeps every region active
+		int32_t regionRadius;
+		RegionStats regionStats;
+		void updateRegionActivation(const Position& pos, int32_t change);
+
+		// called after every dispatcher task
+		void releaseTaskCaches();
+		bool isSpectatorCacheValid(SpectatorCacheEntry& entry, bool onlyPlayers);
+		const SpectatorVec& getCachedSpectators(SpectatorCache& cache, const Position& centerPos, bool onlyPlayers);
 
 		// Actually scans the map for spectators
 		void getSpectatorsInternal(SpectatorVec& list, const Position& centerPos, bool checkforduplicate,
 			int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY,
-			int32_t minRangeZ, int32_t maxRangeZ);
+			int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers = false);
+		void getSpectatorsInRange(SpectatorVec& list, const Position& centerPos, bool multifloor,
+			int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, bool onlyPlayers);
 		// Use this when a custom spectator vector is needed, this support many
 		// more parameters than the heavily cached version below.
 		void getSpectators(SpectatorVec& list, const Position& centerPos, bool checkforduplicate = false, bool multifloor = false,
 			int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0);
-		// The returned SpectatorVec is a temporary and should not be kept around
-		// Take special heed in that the vector will be destroyed if any function
-		// that calls clearSpectatorCache is called.
+		// The returned SpectatorVec is a temporary and should not be kept around,
+		// it is only guaranteed to exist until the current dispatcher task ends.
 		const SpectatorVec& getSpectators(const Position& centerPos);
 
+		// Same as above, but only players are returned. Use these when only
+		// viewers are of interest, they do not walk monsters and npcs.
+		void getPlayerSpectators(SpectatorVec& list, const Position& centerPos, bool multifloor = false,
+			int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0);
+		const SpectatorVec& getPlayerSpectators(const Position& centerPos);
+
 		friend class Game;
 		friend class IOMap;
 };
-
-inline void QTreeLeafNode::addCreature(Creature* c)
-{
-	creatureList.push_back(c);
-}
-
-inline void QTreeLeafNode::removeCreature(Creature* c)
-{
-	CreatureVector::iterator it = std::find(creatureList.begin(), creatureList.end(), c);
-	assert(it != creatureList.end());
-	creatureList.erase(it);
-}
 #endif
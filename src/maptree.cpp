@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "map.h"
+
+#ifdef __FLAT_MAP_GRID__
+//**************** MapGrid **********************
+MapGrid::~MapGrid()
+{
+	for(std::vector<Chunk*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+	{
+		if(!(*it))
+			continue;
+
+		for(int32_t y = 0; y < MAP_GRID_CHUNK_SIZE; ++y)
+		{
+			for(int32_t x = 0; x < MAP_GRID_CHUNK_SIZE; ++x)
+				delete (*it)->leaves[y][x];
+		}
+
+		delete (*it);
+	}
+}
+
+QTreeLeafNode* MapGrid::createLeaf(uint16_t x, uint16_t y)
+{
+	Chunk*& chunk = m_chunks[(y >> MAP_GRID_CHUNK_SHIFT) * MAP_GRID_SIZE + (x >> MAP_GRID_CHUNK_SHIFT)];
+	if(!chunk)
+	{
+		chunk = new Chunk;
+		for(int32_t i = 0; i < MAP_GRID_CHUNK_SIZE; ++i)
+			std::fill(chunk->leaves[i], chunk->leaves[i] + MAP_GRID_CHUNK_SIZE, (QTreeLeafNode*)NULL);
+	}
+
+	QTreeLeafNode*& leaf = chunk->leaves[(y >> FLOOR_BITS) & MAP_GRID_CHUNK_MASK][(x >> FLOOR_BITS) & MAP_GRID_CHUNK_MASK];
+	if(!leaf)
+	{
+		leaf = new QTreeLeafNode();
+		QTreeLeafNode::newLeaf = true;
+	}
+
+	return leaf;
+}
+
+#endif
+//**************** QTreeNode **********************
+QTreeNode::QTreeNode()
+{
+	m_isLeaf = false;
+	for(int32_t i = 0; i < 4; ++i)
+		m_child[i] = NULL;
+}
+
+QTreeNode::~QTreeNode()
+{
+	for(int32_t i = 0; i < 4; ++i)
+		delete m_child[i];
+}
+
+QTreeLeafNode* QTreeNode::getLeaf(uint16_t x, uint16_t y)
+{
+	if(isLeaf())
+		return static_cast<QTreeLeafNode*>(this);
+
+	uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
+	if(m_child[index])
+		return m_child[index]->getLeaf(x * 2, y * 2);
+
+	return NULL;
+}
+
+QTreeLeafNode* QTreeNode::getLeafStatic(QTreeNode* root, uint16_t x, uint16_t y)
+{
+	QTreeNode* currentNode = root;
+	uint32_t currentX = x, currentY = y;
+	while(currentNode)
+	{
+		if(currentNode->isLeaf())
+			return static_cast<QTreeLeafNode*>(currentNode);
+
+		uint32_t index = ((currentX & 0x8000) >> 15) | ((currentY & 0x8000) >> 14);
+		if(!currentNode->m_child[index])
+			return NULL;
+
+		currentNode = currentNode->m_child[index];
+		currentX = currentX * 2;
+		currentY = currentY * 2;
+	}
+
+	return NULL;
+}
+
+QTreeLeafNode* QTreeNode::createLeaf(uint16_t x, uint16_t y, uint16_t level)
+{
+	if(!isLeaf())
+	{
+		uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
+		if(!m_child[index])
+		{
+			if(level != FLOOR_BITS)
+				m_child[index] = new QTreeNode();
+			else
+			{
+				m_child[index] = new QTreeLeafNode();
+				QTreeLeafNode::newLeaf = true;
+			}
+		}
+
+		return m_child[index]->createLeaf(x * 2, y * 2, level - 1);
+	}
+
+	return static_cast<QTreeLeafNode*>(this);
+}
+
+
+//************ LeafNode  ************************
+bool QTreeLeafNode::newLeaf = false;
+uint64_t QTreeLeafNode::changeSequence = 0;
+QTreeLeafNode::QTreeLeafNode()
+{
+	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
+		m_array[i] = NULL;
+
+	m_isLeaf = true;
+	m_leafS = NULL;
+	m_leafE = NULL;
+	m_lastChange = m_lastPlayerChange = 0;
+	m_activePlayers = 0;
+}
+
+QTreeLeafNode::~QTreeLeafNode()
+{
+	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
+		delete m_array[i];
+}
+
+Floor* QTreeLeafNode::createFloor(uint16_t z)
+{
+	if(!m_array[z])
+		m_array[z] = new Floor();
+
+	return m_array[z];
+}
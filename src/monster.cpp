@@ -520,7 +520,7 @@ bool Monster::selectTarget(Creature* creature)
 	}
 
 	if((isHostile() || isSummon()) && setAttackedCreature(creature) && !isSummon())
-		g_dispatcher.addTask(createTask(
+		g_dispatcher.addTask(createTaskWithOrigin("Monster::selectTarget",
 			std::bind(&Game::checkCreatureAttack, &g_game, getID())));
 
 	return setFollowCreature(creature, true);
@@ -565,7 +565,7 @@ void Monster::onAddCondition(ConditionType_t type, bool hadCondition)
 	Creature::onAddCondition(type, hadCondition);
 	//the walkCache need to be updated if the monster becomes "resistent" to the damage, see Tile::__queryAdd()
 	if(type == CONDITION_FIRE || type == CONDITION_ENERGY || type == CONDITION_POISON)
-		updateMapCache();
+		updateMapCache(TILEBIT_MAGICFIELD);
 
 	updateIdleStatus();
 }
@@ -575,7 +575,7 @@ void Monster::onEndCondition(ConditionType_t type)
 	Creature::onEndCondition(type);
 	//the walkCache need to be updated if the monster loose the "resistent" to the damage, see Tile::__queryAdd()
 	if(type == CONDITION_FIRE || type == CONDITION_ENERGY || type == CONDITION_POISON)
-		updateMapCache();
+		updateMapCache(TILEBIT_MAGICFIELD);
 
 	updateIdleStatus();
 }
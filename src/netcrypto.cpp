@@ -0,0 +1,366 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "netcrypto.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define __NETCRYPTO_X86__
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NETCRYPTO_AVX2
+#else
+#define NETCRYPTO_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static constexpr uint32_t XTEA_DELTA = 0x9E3779B9;
+static constexpr uint32_t ADLER_MOD = 65521;
+// largest amount of bytes the scalar Adler-32 may sum before s2 can overflow
+static constexpr size_t ADLER_NMAX = 5552;
+// bytes the vector Adler-32 sums before reducing, keeps every lane inside 32 bits
+static constexpr size_t ADLER_SIMD_CHUNK = 4096;
+
+typedef void (*XteaKernel)(uint32_t*, size_t, const uint32_t*);
+typedef uint32_t (*AdlerKernel)(const uint8_t*, size_t);
+
+// the sum and key schedule does not depend on the data, so every kernel
+// gets the 64 round keys (two per cycle) instead of the raw key
+static void xteaRoundKeys(const uint32_t* key, uint32_t* roundKeys)
+{
+	uint32_t sum = 0;
+	for(int32_t i = 0; i < 32; ++i)
+	{
+		roundKeys[i * 2] = sum + key[sum & 3];
+		sum += XTEA_DELTA;
+		roundKeys[i * 2 + 1] = sum + key[sum >> 11 & 3];
+	}
+}
+
+static void xteaEncryptScalar(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks; --blocks, data += 2)
+	{
+		uint32_t v0 = data[0], v1 = data[1];
+		for(int32_t i = 0; i < 32; ++i)
+		{
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[i * 2];
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[i * 2 + 1];
+		}
+
+		data[0] = v0;
+		data[1] = v1;
+	}
+}
+
+static void xteaDecryptScalar(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks; --blocks, data += 2)
+	{
+		uint32_t v0 = data[0], v1 = data[1];
+		for(int32_t i = 31; i >= 0; --i)
+		{
+			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[i * 2 + 1];
+			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[i * 2];
+		}
+
+		data[0] = v0;
+		data[1] = v1;
+	}
+}
+
+static void adlerScalar(const uint8_t* data, size_t length, uint32_t& s1, uint32_t& s2)
+{
+	while(length)
+	{
+		size_t chunk = std::min(length, ADLER_NMAX);
+		length -= chunk;
+		for(; chunk; --chunk)
+		{
+			s1 += *data++;
+			s2 += s1;
+		}
+
+		s1 %= ADLER_MOD;
+		s2 %= ADLER_MOD;
+	}
+}
+
+static uint32_t adler32Scalar(const uint8_t* data, size_t length)
+{
+	uint32_t s1 = 1, s2 = 0;
+	adlerScalar(data, length, s1, s2);
+	return s2 << 16 | s1;
+}
+
+#ifdef __NETCRYPTO_X86__
+// the vector kernels split the pairs of blocks into a vector of first words
+// and one of second words, and run the rounds on all of them at once
+
+static void xteaEncryptSSE2(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks >= 4; blocks -= 4, data += 8)
+	{
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)data)),
+			b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(data + 4)));
+		__m128i v0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+			v1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		for(int32_t i = 0; i < 32; ++i)
+		{
+			v0 = _mm_add_epi32(v0, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4),
+				_mm_srli_epi32(v1, 5)), v1), _mm_set1_epi32(roundKeys[i * 2])));
+			v1 = _mm_add_epi32(v1, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4),
+				_mm_srli_epi32(v0, 5)), v0), _mm_set1_epi32(roundKeys[i * 2 + 1])));
+		}
+
+		_mm_storeu_si128((__m128i*)data, _mm_unpacklo_epi32(v0, v1));
+		_mm_storeu_si128((__m128i*)(data + 4), _mm_unpackhi_epi32(v0, v1));
+	}
+
+	xteaEncryptScalar(data, blocks, roundKeys);
+}
+
+static void xteaDecryptSSE2(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks >= 4; blocks -= 4, data += 8)
+	{
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)data)),
+			b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(data + 4)));
+		__m128i v0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+			v1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		for(int32_t i = 31; i >= 0; --i)
+		{
+			v1 = _mm_sub_epi32(v1, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4),
+				_mm_srli_epi32(v0, 5)), v0), _mm_set1_epi32(roundKeys[i * 2 + 1])));
+			v0 = _mm_sub_epi32(v0, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4),
+				_mm_srli_epi32(v1, 5)), v1), _mm_set1_epi32(roundKeys[i * 2])));
+		}
+
+		_mm_storeu_si128((__m128i*)data, _mm_unpacklo_epi32(v0, v1));
+		_mm_storeu_si128((__m128i*)(data + 4), _mm_unpackhi_epi32(v0, v1));
+	}
+
+	xteaDecryptScalar(data, blocks, roundKeys);
+}
+
+static uint32_t adler32SSE2(const uint8_t* data, size_t length)
+{
+	const __m128i zero = _mm_setzero_si128(), weightsLo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9),
+		weightsHi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+
+	uint32_t s1 = 1, s2 = 0;
+	while(length >= 16)
+	{
+		size_t chunk = std::min(length, ADLER_SIMD_CHUNK) & ~(size_t)15;
+		length -= chunk;
+
+		// every byte of the chunk adds the starting s1 to s2 once
+		uint64_t sum2 = s2 + (uint64_t)s1 * chunk;
+		__m128i vs1 = zero, vs2 = zero, vs1Sum = zero;
+		for(const uint8_t* end = data + chunk; data != end; data += 16)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)data);
+			vs1Sum = _mm_add_epi32(vs1Sum, vs1);
+			vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(bytes, zero));
+			vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLo));
+			vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHi));
+		}
+
+		uint32_t lanes1[4], lanes2[4], lanesSum[4];
+		_mm_storeu_si128((__m128i*)lanes1, vs1);
+		_mm_storeu_si128((__m128i*)lanes2, vs2);
+		_mm_storeu_si128((__m128i*)lanesSum, vs1Sum);
+		for(int32_t i = 0; i < 4; ++i)
+		{
+			s1 += lanes1[i];
+			sum2 += lanes2[i] + ((uint64_t)lanesSum[i] << 4);
+		}
+
+		s1 %= ADLER_MOD;
+		s2 = sum2 % ADLER_MOD;
+	}
+
+	adlerScalar(data, length, s1, s2);
+	return s2 << 16 | s1;
+}
+
+NETCRYPTO_AVX2 static void xteaEncryptAVX2(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks >= 8; blocks -= 8, data += 16)
+	{
+		__m256 a = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)data)),
+			b = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(data + 8)));
+		__m256i v0 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+			v1 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		for(int32_t i = 0; i < 32; ++i)
+		{
+			v0 = _mm256_add_epi32(v0, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4),
+				_mm256_srli_epi32(v1, 5)), v1), _mm256_set1_epi32(roundKeys[i * 2])));
+			v1 = _mm256_add_epi32(v1, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4),
+				_mm256_srli_epi32(v0, 5)), v0), _mm256_set1_epi32(roundKeys[i * 2 + 1])));
+		}
+
+		// the shuffles and unpacks both work within 128-bit lanes, so they undo each other
+		_mm256_storeu_si256((__m256i*)data, _mm256_unpacklo_epi32(v0, v1));
+		_mm256_storeu_si256((__m256i*)(data + 8), _mm256_unpackhi_epi32(v0, v1));
+	}
+
+	xteaEncryptSSE2(data, blocks, roundKeys);
+}
+
+NETCRYPTO_AVX2 static void xteaDecryptAVX2(uint32_t* data, size_t blocks, const uint32_t* roundKeys)
+{
+	for(; blocks >= 8; blocks -= 8, data += 16)
+	{
+		__m256 a = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)data)),
+			b = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(data + 8)));
+		__m256i v0 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+			v1 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		for(int32_t i = 31; i >= 0; --i)
+		{
+			v1 = _mm256_sub_epi32(v1, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4),
+				_mm256_srli_epi32(v0, 5)), v0), _mm256_set1_epi32(roundKeys[i * 2 + 1])));
+			v0 = _mm256_sub_epi32(v0, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4),
+				_mm256_srli_epi32(v1, 5)), v1), _mm256_set1_epi32(roundKeys[i * 2])));
+		}
+
+		_mm256_storeu_si256((__m256i*)data, _mm256_unpacklo_epi32(v0, v1));
+		_mm256_storeu_si256((__m256i*)(data + 8), _mm256_unpackhi_epi32(v0, v1));
+	}
+
+	xteaDecryptSSE2(data, blocks, roundKeys);
+}
+
+NETCRYPTO_AVX2 static uint32_t adler32AVX2(const uint8_t* data, size_t length)
+{
+	const __m256i zero = _mm256_setzero_si256(), ones = _mm256_set1_epi16(1),
+		weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+			16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+
+	uint32_t s1 = 1, s2 = 0;
+	while(length >= 32)
+	{
+		size_t chunk = std::min(length, ADLER_SIMD_CHUNK) & ~(size_t)31;
+		length -= chunk;
+
+		uint64_t sum2 = s2 + (uint64_t)s1 * chunk;
+		__m256i vs1 = zero, vs2 = zero, vs1Sum = zero;
+		for(const uint8_t* end = data + chunk; data != end; data += 32)
+		{
+			__m256i bytes = _mm256_loadu_si256((const __m256i*)data);
+			vs1Sum = _mm256_add_epi32(vs1Sum, vs1);
+			vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(bytes, zero));
+			vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+		}
+
+		uint32_t lanes1[8], lanes2[8], lanesSum[8];
+		_mm256_storeu_si256((__m256i*)lanes1, vs1);
+		_mm256_storeu_si256((__m256i*)lanes2, vs2);
+		_mm256_storeu_si256((__m256i*)lanesSum, vs1Sum);
+		for(int32_t i = 0; i < 8; ++i)
+		{
+			s1 += lanes1[i];
+			sum2 += lanes2[i] + ((uint64_t)lanesSum[i] << 5);
+		}
+
+		s1 %= ADLER_MOD;
+		s2 = sum2 % ADLER_MOD;
+	}
+
+	adlerScalar(data, length, s1, s2);
+	return s2 << 16 | s1;
+}
+
+static bool hasAVX2()
+{
+#ifdef _MSC_VER
+	int32_t info[4];
+	__cpuid(info, 1);
+	// the OS has to save the ymm registers too
+	if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return info[1] & (1 << 5);
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct NetCryptoKernels
+{
+	XteaKernel encrypt, decrypt;
+	AdlerKernel adler;
+	const char* name;
+};
+
+static NetCryptoKernels selectKernels()
+{
+#ifdef __NETCRYPTO_X86__
+	if(hasAVX2())
+		return {xteaEncryptAVX2, xteaDecryptAVX2, adler32AVX2, "AVX2"};
+
+	return {xteaEncryptSSE2, xteaDecryptSSE2, adler32SSE2, "SSE2"};
+#else
+	return {xteaEncryptScalar, xteaDecryptScalar, adler32Scalar, "scalar"};
+#endif
+}
+
+static NetCryptoKernels kernels = selectKernels();
+
+void xteaEncrypt(uint32_t* data, size_t blocks, const uint32_t* key)
+{
+	uint32_t roundKeys[64];
+	xteaRoundKeys(key, roundKeys);
+	kernels.encrypt(data, blocks, roundKeys);
+}
+
+void xteaDecrypt(uint32_t* data, size_t blocks, const uint32_t* key)
+{
+	uint32_t roundKeys[64];
+	xteaRoundKeys(key, roundKeys);
+	kernels.decrypt(data, blocks, roundKeys);
+}
+
+uint32_t adler32(const uint8_t* data, size_t length)
+{
+	return kernels.adler(data, length);
+}
+
+const char* getNetCryptoKernel()
+{
+	return kernels.name;
+}
+
+bool setNetCryptoKernel(const std::string& name)
+{
+	if(name == "scalar")
+		kernels = {xteaEncryptScalar, xteaDecryptScalar, adler32Scalar, "scalar"};
+#ifdef __NETCRYPTO_X86__
+	else if(name == "SSE2")
+		kernels = {xteaEncryptSSE2, xteaDecryptSSE2, adler32SSE2, "SSE2"};
+	else if(name == "AVX2" && hasAVX2())
+		kernels = {xteaEncryptAVX2, xteaDecryptAVX2, adler32AVX2, "AVX2"};
+#endif
+	else
+		return false;
+
+	return true;
+}
@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __NETCRYPTO__
+#define __NETCRYPTO__
+
+// XTEA and Adler-32 for the network protocol. The kernels are picked once at
+// startup by CPU feature detection: AVX2, SSE2 or the plain scalar loop, all
+// of them produce the same bytes.
+
+// data holds blocks pairs of 32-bit words, encrypted in place
+void xteaEncrypt(uint32_t* data, size_t blocks, const uint32_t* key);
+void xteaDecrypt(uint32_t* data, size_t blocks, const uint32_t* key);
+
+uint32_t adler32(const uint8_t* data, size_t length);
+
+// name of the selected kernels, for diagnostics
+const char* getNetCryptoKernel();
+// switches to the named kernels ("AVX2", "SSE2" or "scalar"), false when the
+// CPU lacks them; only for the benchmark, the server keeps the detected ones
+bool setNetCryptoKernel(const std::string& name);
+#endif
@@ -363,6 +363,7 @@ class Npc : public Creature
 
 		virtual bool canSee(const Position& pos) const;
 		virtual bool canSeeInvisibility() const {return true;}
+		virtual bool hasThinkPriority() const {return focusCreature || !isIdle || !queueList.empty() || Creature::hasThinkPriority();}
 
 		bool isLoaded() {return loaded;}
 		bool load();
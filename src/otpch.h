@@ -38,6 +38,8 @@
 #include <cmath>
 #include <memory>
 #include <unordered_set>
+#include <unordered_map>
+#include <deque>
 
 #include <ctime>
 #include <cassert>
@@ -50,6 +50,8 @@
 
 #include "monsters.h"
 #include "scheduler.h"
+#include "pathfinding.h"
+#include "cryptopool.h"
 #include "admin.h"
 #include "textlogger.h"
 #include "tools.h"
@@ -62,6 +64,8 @@ Monsters g_monsters;
 Npcs g_npcs;
 Dispatcher g_dispatcher;
 Scheduler g_scheduler;
+PathfindingPool g_pathfinding;
+CryptoPool g_cryptoPool;
 
 std::mutex g_loaderLock;
 std::condition_variable g_loaderSignal;
@@ -155,7 +159,7 @@ void signalHandler(int32_t sig)
 	switch(sig)
 	{
 		case SIGHUP:
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("signalHandler",
 				std::bind(&Game::saveGameState, &g_game, false)));
 			break;
 
@@ -168,7 +172,7 @@ void signalHandler(int32_t sig)
 			break;
 
 		case SIGUSR1:
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("signalHandler",
 				std::bind(&Game::setGameState, &g_game, GAMESTATE_CLOSED)));
 			break;
 
@@ -177,17 +181,17 @@ void signalHandler(int32_t sig)
 			break;
 
 		case SIGCONT:
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("signalHandler",
 				std::bind(&Game::reloadInfo, &g_game, RELOAD_ALL, 0)));
 			break;
 
 		case SIGQUIT:
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("signalHandler",
 				std::bind(&Game::setGameState, &g_game, GAMESTATE_SHUTDOWN)));
 			break;
 
 		case SIGTERM:
-			g_dispatcher.addTask(createTask(
+			g_dispatcher.addTask(createTaskWithOrigin("signalHandler",
 				std::bind(&Game::shutdown, &g_game)));
 			break;
 
@@ -271,7 +275,7 @@ int main(int argc, char* argv[])
 #endif
 
 	OutputHandler::getInstance();
-	g_dispatcher.addTask(createTask(std::bind(otserv, args, &servicer)));
+	g_dispatcher.addTask(createTaskWithOrigin("main", std::bind(otserv, args, &servicer)));
 
 	g_loaderSignal.wait(g_loaderUniqueLock);
 	
@@ -53,6 +53,7 @@ void OutputMessagePool::startExecutionFrame()
 	//std::lock_guard<std::recursive_mutex> lockClass(m_outputPoolLock);
 	m_frameTime = OTSYS_TIME();
 	m_shutdown = false;
+	collectReleased();
 }
 
 OutputMessagePool::~OutputMessagePool()
@@ -126,9 +127,13 @@ void OutputMessagePool::sendAll()
 			#ifdef __DEBUG_NET_DETAIL__
 			std::clog << "Sending message - ALL" << std::endl;
 			#endif
-			if(omsg->getConnection())
+			if(Connection_ptr connection = omsg->getConnection())
 			{
-				if(!omsg->getConnection()->send(omsg) && omsg->getProtocol())
+				//corked until the whole frame is queued, see below; a connection
+				//that is still writing puts the message back in m_addQueue
+				if(connection->send(omsg, true))
+					m_corked.push_back(connection);
+				else if(omsg->getProtocol())
 					omsg->getProtocol()->onSendMessage(omsg);
 			}
 			#ifdef __DEBUG_NET__
@@ -141,33 +146,52 @@ void OutputMessagePool::sendAll()
 		else
 			++it;
 	}
+
+	for(std::vector<Connection_ptr>::iterator it = m_corked.begin(); it != m_corked.end(); ++it)
+		(*it)->flush();
+
+	m_corked.clear();
 }
 
 void OutputMessagePool::releaseMessage(OutputMessage* msg)
 {
-	g_dispatcher.addTask(createTask(std::bind(
-		&OutputMessagePool::internalReleaseMessage, this, msg)), true);
+	OutputMessage* head = m_released.load(std::memory_order_relaxed);
+	do
+		msg->m_next = head;
+	while(!m_released.compare_exchange_weak(head, msg, std::memory_order_release, std::memory_order_relaxed));
 }
 
-void OutputMessagePool::internalReleaseMessage(OutputMessage* msg)
+void OutputMessagePool::collectReleased()
 {
-	if(msg->getProtocol())
-		msg->getProtocol()->unRef();
-	else
-		std::clog << "[Warning - OutputMessagePool::internalReleaseMessage] protocol not found." << std::endl;
+	if(!m_released.load(std::memory_order_relaxed))
+		return;
 
-	if(msg->getConnection())
-		msg->getConnection()->unRef();
-	else
-		std::clog << "[Warning - OutputMessagePool::internalReleaseMessage] connection not found." << std::endl;
+	InternalList freed;
+	for(OutputMessage* msg = m_released.exchange(NULL, std::memory_order_acquire); msg; )
+	{
+		OutputMessage* next = msg->m_next;
+		msg->m_next = NULL;
+		if(msg->getProtocol())
+			msg->getProtocol()->unRef();
+		else
+			std::clog << "[Warning - OutputMessagePool::collectReleased] protocol not found." << std::endl;
 
-	msg->freeMessage();
+		if(msg->getConnection())
+			msg->getConnection()->unRef();
+		else
+			std::clog << "[Warning - OutputMessagePool::collectReleased] connection not found." << std::endl;
+
+		msg->freeMessage();
 #ifdef __TRACK_NETWORK__
-	msg->clearTrack();
+		msg->clearTrack();
 #endif
 
+		freed.push_back(msg);
+		msg = next;
+	}
+
 	m_outputPoolLock.lock();
-	m_outputMessages.push_back(msg);
+	m_outputMessages.splice(m_outputMessages.end(), freed);
 	m_outputPoolLock.unlock();
 }
 
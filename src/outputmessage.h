@@ -27,7 +27,7 @@ class Protocol;
 class OutputMessage : public NetworkMessage
 {
 	private:
-		OutputMessage() {freeMessage();}
+		OutputMessage(): m_next(NULL) {freeMessage();}
 
 	public:
 		// non-copyable
@@ -118,6 +118,8 @@ class OutputMessage : public NetworkMessage
 
 		Protocol* m_protocol;
 		Connection_ptr m_connection;
+		// link in OutputMessagePool::m_released
+		OutputMessage* m_next;
 #ifdef __TRACK_NETWORK__
 		std::list<std::string> lastUses;
 #endif
@@ -166,18 +168,24 @@ class OutputMessagePool
 	protected:
 		void configureOutputMessage(OutputMessage_ptr msg, Protocol* protocol, bool autoSend);
 
+		// may run on any thread, the message only waits for collectReleased
 		void releaseMessage(OutputMessage* msg);
-		void internalReleaseMessage(OutputMessage* msg);
+		// dispatcher thread, drops the references of the released messages at once
+		void collectReleased();
 
 		typedef std::list<OutputMessage_ptr> OutputMessageList;
 		OutputMessageList m_autoSend;
 		OutputMessageList m_addQueue;
+		// connections that got messages during sendAll, flushed once it is done
+		std::vector<Connection_ptr> m_corked;
 
 		typedef std::list<OutputMessage*> InternalList;
 		InternalList m_outputMessages;
 		InternalList m_allMessages;
 
 		std::recursive_mutex m_outputPoolLock;
+		// lock-free stack of released messages, pushed with a single CAS
+		std::atomic<OutputMessage*> m_released{NULL};
 		uint64_t m_frameTime;
 		bool m_shutdown;
 };
@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "pathfinding.h"
+
+#include "dispatcher.h"
+#include "game.h"
+#include "map.h"
+
+extern Game g_game;
+
+PathSnapshot::PathSnapshot(const Creature* creature, const Position& targetPos, const FindPathParams& fpp):
+	m_startPos(creature->getPosition()), m_targetPos(targetPos), m_fpp(fpp)
+{
+	m_radius = std::max((int32_t)0, fpp.maxSearchDist);
+	m_width = m_radius * 2 + 1;
+	m_cost.assign(m_width * m_width, -1);
+
+	//the floor bits answer most tiles a row at a time, free tiles hold nothing
+	//that costs extra, only the rest goes through canWalkTo
+	Map* map = g_game.getMap();
+	Position pos(0, 0, m_startPos.z);
+	std::vector<uint8_t> states(m_width);
+	for(int32_t y = m_startPos.y - m_radius; y <= m_startPos.y + m_radius; ++y)
+	{
+		if(y < 0 || y > 0xFFFF)
+			continue;
+
+		pos.y = y;
+		int32_t startX = m_startPos.x - m_radius;
+		map->getPathStates(startX, y, m_startPos.z, m_width, &states[0], creature);
+		for(int32_t i = 0; i < m_width; ++i)
+		{
+			int32_t x = startX + i;
+			if(states[i] == PATHSTATE_BLOCKED || x < 0 || x > 0xFFFF)
+				continue;
+
+			if(states[i] == PATHSTATE_FREE)
+			{
+				m_cost[getIndex(x, y)] = 0;
+				continue;
+			}
+
+			pos.x = x;
+			if(const Tile* tile = map->canWalkTo(creature, pos))
+				m_cost[getIndex(x, y)] = AStarNodes::getTileWalkCost(creature, tile);
+		}
+	}
+
+	if(!fpp.clearSight)
+		return;
+
+	//the path condition only asks for sight within maxTargetDist of the target,
+	//and the search never gets to tiles the creature cannot walk on
+	m_sight.assign(m_width * m_width, false);
+	int32_t range = std::max((int32_t)0, fpp.maxTargetDist);
+	for(int32_t y = m_targetPos.y - range; y <= m_targetPos.y + range; ++y)
+	{
+		for(int32_t x = m_targetPos.x - range; x <= m_targetPos.x + range; ++x)
+		{
+			int32_t index = getIndex(x, y);
+			if(index != -1 && m_cost[index] >= 0)
+				m_sight[index] = g_game.isSightClear(Position(x, y, m_startPos.z), m_targetPos, true);
+		}
+	}
+}
+
+int32_t PathSnapshot::getIndex(int32_t x, int32_t y) const
+{
+	int32_t dx = x - m_startPos.x, dy = y - m_startPos.y;
+	if(std::abs(dx) > m_radius || std::abs(dy) > m_radius)
+		return -1;
+
+	return (dy + m_radius) * m_width + (dx + m_radius);
+}
+
+bool PathSnapshot::canWalk(const Position& pos, int32_t& extraCost) const
+{
+	int32_t index = getIndex(pos.x, pos.y);
+	if(index == -1 || pos.z != m_startPos.z || m_cost[index] < 0)
+		return false;
+
+	extraCost = m_cost[index];
+	return true;
+}
+
+bool PathSnapshot::isSightClear(const Position& pos) const
+{
+	int32_t index = getIndex(pos.x, pos.y);
+	return index != -1 && !m_sight.empty() && m_sight[index];
+}
+
+FlowField::FlowField(const Position& targetPos):
+	m_targetPos(targetPos), m_created(OTSYS_TIME())
+{
+	const int32_t width = Map::maxViewportX * 2 + 1, height = Map::maxViewportY * 2 + 1;
+	m_distance.assign(width * height, -1);
+
+	static const int32_t neighbourOrderList[8][2] =
+	{
+		{-1, 0}, {0, 1}, {1, 0}, {0, -1},
+		{-1, -1}, {1, -1}, {1, 1}, {-1, 1}
+	};
+
+	//only what no creature can pass, the chasers check their own way when walking it
+	Map* map = g_game.getMap();
+	std::vector<int8_t> passable(width * height, -1);
+
+	typedef std::pair<int32_t, int32_t> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+
+	int32_t start = Map::maxViewportY * width + Map::maxViewportX;
+	m_distance[start] = 0;
+	queue.push(Entry(0, start));
+	while(!queue.empty())
+	{
+		Entry entry = queue.top();
+		queue.pop();
+		if(entry.first > m_distance[entry.second])
+			continue;
+
+		int32_t cx = entry.second % width, cy = entry.second / width;
+		for(int32_t i = 0; i < 8; ++i)
+		{
+			int32_t nx = cx + neighbourOrderList[i][0], ny = cy + neighbourOrderList[i][1];
+			if(nx < 0 || nx >= width || ny < 0 || ny >= height)
+				continue;
+
+			int32_t index = ny * width + nx;
+			if(passable[index] == -1)
+			{
+				int32_t x = m_targetPos.x + nx - Map::maxViewportX, y = m_targetPos.y + ny - Map::maxViewportY;
+				const Tile* tile = NULL;
+				if(x >= 0 && y >= 0 && x <= 0xFFFF && y <= 0xFFFF)
+					tile = map->getTile(x, y, m_targetPos.z);
+
+				passable[index] = (tile && tile->ground && !tile->hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID)
+					&& !tile->hasFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH) && !tile->floorChange()
+					&& !tile->positionChange());
+			}
+
+			if(!passable[index])
+				continue;
+
+			int32_t distance = entry.first + (i < 4 ? MAP_NORMALWALKCOST : MAP_DIAGONALWALKCOST);
+			if(m_distance[index] != -1 && m_distance[index] <= distance)
+				continue;
+
+			m_distance[index] = distance;
+			queue.push(Entry(distance, index));
+		}
+	}
+}
+
+int32_t FlowField::getDistance(int32_t x, int32_t y) const
+{
+	int32_t dx = x - m_targetPos.x, dy = y - m_targetPos.y;
+	if(std::abs(dx) > Map::maxViewportX || std::abs(dy) > Map::maxViewportY)
+		return -1;
+
+	return m_distance[(dy + Map::maxViewportY) * (Map::maxViewportX * 2 + 1) + (dx + Map::maxViewportX)];
+}
+
+bool FlowField::getPath(const Creature* creature, const FrozenPathingConditionCall& pathCondition,
+	const FindPathParams& fpp, std::list<Direction>& dirList) const
+{
+	static const int32_t neighbourOrderList[8][2] =
+	{
+		{-1, 0}, {0, 1}, {1, 0}, {0, -1},
+		{-1, -1}, {1, -1}, {1, 1}, {-1, 1}
+	};
+	static const Direction neighbourDirList[8] =
+	{
+		WEST, SOUTH, EAST, NORTH,
+		NORTHWEST, NORTHEAST, SOUTHEAST, SOUTHWEST
+	};
+
+	const Position& startPos = creature->getPosition();
+	if(startPos.z != m_targetPos.z)
+		return false;
+
+	Map* map = g_game.getMap();
+	Position pos = startPos, next;
+
+	dirList.clear();
+	int32_t bestMatch = 0, dirCount = (fpp.allowDiagonal ? 8 : 4);
+	while(true)
+	{
+		if(pathCondition(startPos, pos, fpp, bestMatch))
+			return true;
+
+		int32_t distance = getDistance(pos.x, pos.y), best = -1;
+		if(distance == -1)
+			break;
+
+		for(int32_t i = 0; i < dirCount; ++i)
+		{
+			next = Position(pos.x + neighbourOrderList[i][0], pos.y + neighbourOrderList[i][1], pos.z);
+			if(fpp.maxSearchDist != -1 && (std::abs(startPos.x - next.x) > fpp.maxSearchDist ||
+				std::abs(startPos.y - next.y) > fpp.maxSearchDist))
+				continue;
+
+			int32_t nextDistance = getDistance(next.x, next.y);
+			if(nextDistance == -1 || nextDistance >= distance || !map->canWalkTo(creature, next))
+				continue;
+
+			distance = nextDistance;
+			best = i;
+		}
+
+		if(best == -1)
+			break;
+
+		pos.x += neighbourOrderList[best][0];
+		pos.y += neighbourOrderList[best][1];
+		dirList.push_back(neighbourDirList[best]);
+	}
+
+	dirList.clear();
+	return false;
+}
+
+PathJob::PathJob(const Creature* creature, const Creature* target, uint32_t _requestId, const FindPathParams& fpp):
+	creatureId(creature->getID()), targetId(target->getID()), requestId(_requestId),
+	snapshot(creature, target->getPosition(), fpp), found(false) {}
+
+void PathfindingPool::start(uint32_t threads)
+{
+	if(m_running || !threads)
+		return;
+
+	m_running = true;
+	for(uint32_t i = 0; i < threads; ++i)
+		m_threads.push_back(std::thread(&PathfindingPool::threadMain, this));
+}
+
+void PathfindingPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(m_jobLock);
+		if(!m_running)
+			return;
+
+		m_running = false;
+		m_stats.dropped += m_jobs.size();
+		m_stats.queueSize = 0;
+		m_jobs.clear();
+	}
+
+	m_jobSignal.notify_all();
+	for(std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+	{
+		if(it->joinable())
+			it->join();
+	}
+
+	m_threads.clear();
+}
+
+void PathfindingPool::addJob(const std::shared_ptr<PathJob>& job)
+{
+	{
+		std::lock_guard<std::mutex> lockClass(m_jobLock);
+		if(!m_running)
+			return;
+
+		m_jobs.push_back(job);
+		++m_stats.queueSize;
+	}
+
+	m_jobSignal.notify_one();
+}
+
+void PathfindingPool::threadMain()
+{
+	std::unique_lock<std::mutex> jobLockUnique(m_jobLock, std::defer_lock);
+	while(true)
+	{
+		jobLockUnique.lock();
+		m_jobSignal.wait(jobLockUnique, [this] {return !m_running || !m_jobs.empty();});
+		if(!m_running)
+			break;
+
+		std::shared_ptr<PathJob> job = m_jobs.front();
+		m_jobs.pop_front();
+		--m_stats.queueSize;
+		jobLockUnique.unlock();
+
+		job->found = Map::getPathMatching(job->snapshot, job->dirList);
+		++m_stats.jobs;
+
+		g_dispatcher.addTask(createTaskWithOrigin("PathfindingPool::completeJob",
+			std::bind(&PathfindingPool::completeJob, job)));
+	}
+}
+
+void PathfindingPool::completeJob(std::shared_ptr<PathJob> job)
+{
+	Creature* creature = g_game.getCreatureByID(job->creatureId);
+	if(creature && creature->getHealth() > 0)
+		creature->onFollowPath(*job);
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __PATHFINDING__
+#define __PATHFINDING__
+#include "creature.h"
+
+// Walkability of the search window around a creature, taken on the
+// dispatcher so that the search itself can run on a worker thread.
+class PathSnapshot
+{
+	public:
+		PathSnapshot(const Creature* creature, const Position& targetPos, const FindPathParams& fpp);
+
+		bool canWalk(const Position& pos, int32_t& extraCost) const;
+		bool isSightClear(const Position& pos) const;
+
+		const Position& getStartPos() const {return m_startPos;}
+		const Position& getTargetPos() const {return m_targetPos;}
+		const FindPathParams& getParams() const {return m_fpp;}
+
+	protected:
+		int32_t getIndex(int32_t x, int32_t y) const;
+
+		Position m_startPos, m_targetPos;
+		FindPathParams m_fpp;
+
+		int32_t m_radius, m_width;
+		// extra walk cost of each cell, -1 if the creature cannot walk there
+		std::vector<int16_t> m_cost;
+		// only filled around the target when fpp.clearSight is set
+		std::vector<bool> m_sight;
+};
+
+// Distances toward a creature over the tiles around it, built once per
+// target position and walked downhill by every monster chasing that target.
+class FlowField
+{
+	public:
+		FlowField(const Position& targetPos);
+
+		// follows the field from the creature until pathCondition matches, false
+		// when the creature cannot walk any step that gets it closer
+		bool getPath(const Creature* creature, const FrozenPathingConditionCall& pathCondition,
+			const FindPathParams& fpp, std::list<Direction>& dirList) const;
+
+		const Position& getTargetPos() const {return m_targetPos;}
+		int64_t getCreated() const {return m_created;}
+
+	protected:
+		int32_t getDistance(int32_t x, int32_t y) const;
+
+		Position m_targetPos;
+		int64_t m_created;
+		// walk cost from each cell to the target, -1 where it is unreachable
+		std::vector<int32_t> m_distance;
+};
+
+struct PathJob
+{
+	PathJob(const Creature* creature, const Creature* target, uint32_t _requestId, const FindPathParams& fpp);
+
+	uint32_t creatureId, targetId, requestId;
+	PathSnapshot snapshot;
+
+	std::list<Direction> dirList;
+	bool found;
+};
+
+struct PathfindingStats
+{
+	std::atomic<uint64_t> jobs{0}, dropped{0};
+	std::atomic<uint32_t> queueSize{0};
+};
+
+class PathfindingPool
+{
+	public:
+		PathfindingPool() {}
+		virtual ~PathfindingPool() {shutdown();}
+
+		// threads = 0 keeps pathfinding synchronous on the dispatcher
+		void start(uint32_t threads);
+		void shutdown();
+
+		bool isRunning() const {return m_running;}
+		uint32_t getThreadCount() const {return m_threads.size();}
+
+		void addJob(const std::shared_ptr<PathJob>& job);
+
+		const PathfindingStats& getStats() const {return m_stats;}
+
+	protected:
+		void threadMain();
+		static void completeJob(std::shared_ptr<PathJob> job);
+
+		std::mutex m_jobLock;
+		std::condition_variable m_jobSignal;
+		std::deque<std::shared_ptr<PathJob> > m_jobs;
+
+		std::vector<std::thread> m_threads;
+		std::atomic<bool> m_running{false};
+
+		PathfindingStats m_stats;
+};
+extern PathfindingPool g_pathfinding;
+#endif
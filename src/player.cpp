@@ -31,6 +31,7 @@
 #include "movement.h"
 
 #include "configmanager.h"
+#include "outputmessage.h"
 #include "game.h"
 #include "chat.h"
 #include "weapons.h"
@@ -48,6 +49,7 @@ AutoList<Player> Player::castAutoList;
 AutoList<Player> Player::autoList;
 AutoList<ProtocolGame> Player::cSpectators;
 uint32_t Player::nextSpectator = 0;
+CastStats Player::castStats;
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
 uint32_t Player::playerCount = 0;
 #endif
@@ -69,7 +71,7 @@ Player::Player(const std::string& _name, ProtocolGame* p):
 	accountManager = MANAGER_NONE;
 	guildLevel = GUILDLEVEL_NONE;
 
-	promotionLevel = walkTaskEvent = actionTaskEvent = nextStepEvent = bloodHitCount = shieldBlockCount = 0;
+	castCaptureDepth = promotionLevel = walkTaskEvent = actionTaskEvent = nextStepEvent = bloodHitCount = shieldBlockCount = 0;
 	lastAttack = idleTime = marriage = blessings = balance = premiumDays = mana = manaMax = manaSpent = extraAttackSpeed = 0;
 	soul = guildId = levelPercent = magLevelPercent = magLevel = experience = damageImmunities = 0;
 	conditionImmunities = conditionSuppressions = groupId = vocationId = managerNumber2 = town = skullEnd = 0;
@@ -542,11 +544,8 @@ void Player::sendIcons() const
 	if(pzLocked)
 		icons |= ICON_PZ;
 
+	CastCapture capture(this);
 	client->sendIcons(icons);
-	
-	for(AutoList<ProtocolGame>::const_iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it) //CAST
-		if(it->second->getPlayer() == this)
-			it->second->sendIcons(icons);
 }
 
 /*void Player::updateInventoryWeight()
@@ -1273,6 +1272,54 @@ void Player::sendHouseWindow(House* house, uint32_t listId) const
 		client->sendHouseWindow(windowTextId, house, listId, text);
 }
 
+Player::CastCapture::CastCapture(const Player* player):
+	m_player(player), m_start(0)
+{
+	//a send made from within another captured send is already part of the
+	//outer capture, copying it again would duplicate it for viewers
+	if(player->castCaptureDepth++ || !player->client || !player->cast.isCasting)
+		return;
+
+	m_msg = player->client->getOutputBuffer();
+	if(m_msg)
+		m_start = m_msg->position();
+}
+
+Player::CastCapture::~CastCapture()
+{
+	--m_player->castCaptureDepth;
+	if(!m_msg || !m_player->client || m_player->client->getOutputBuffer() != m_msg
+		|| m_msg->position() <= m_start)
+		return;
+
+	m_player->sendCastData(m_msg->buffer() + m_start, m_msg->position() - m_start);
+}
+
+void Player::sendCastData(const char* data, uint16_t size) const
+{
+	++castStats.packets;
+	castStats.bytes += size;
+
+	std::vector<uint32_t> slowViewers;
+	for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it)
+	{
+		if(it->second->getPlayer() != this)
+			continue;
+
+		if(it->second->sendCastData(data, size))
+			++castStats.copies;
+		else
+			slowViewers.push_back(it->first);
+	}
+
+	//a viewer that cannot keep up would otherwise hold the cast in memory
+	for(std::vector<uint32_t>::iterator it = slowViewers.begin(); it != slowViewers.end(); ++it)
+	{
+		kickCastViewer(*it);
+		++castStats.dropped;
+	}
+}
+
 void Player::sendCreatureChangeVisible(const Creature* creature, Visible_t visible)
 {
 	if(!client)
@@ -1296,12 +1343,8 @@ void Player::sendAddContainerItem(const Container* container, const Item* item)
 	for(ContainerVector::const_iterator cl = containerVec.begin(); cl != containerVec.end(); ++cl)
 	{
 		if(cl->second == container) {
+			CastCapture capture(this);
 			client->sendAddContainerItem(cl->first, item);
-
-			//CAST
-			for(AutoList<ProtocolGame>::iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it)
-				if(it->second->getPlayer() == this)
-					it->second->sendAddContainerItem(cl->first, item);
 		}
 	}
 }
@@ -1314,11 +1357,9 @@ void Player::sendUpdateContainerItem(const Container* container, uint8_t slot, c
 	for(ContainerVector::const_iterator cl = containerVec.begin(); cl != containerVec.end(); ++cl)
 	{
 		if(cl->second == container) {
+			CastCapture capture(this);
 			client->sendUpdateContainerItem(cl->first, slot, newItem);
-			for(AutoList<ProtocolGame>::iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it)
-				if(it->second->getPlayer() == this)
-					it->second->sendUpdateContainerItem(cl->first, slot, newItem); //CAST
-         }
+		}
 	}
 }
 
@@ -1330,10 +1371,8 @@ void Player::sendRemoveContainerItem(const Container* container, uint8_t slot, c
 	for(ContainerVector::const_iterator cl = containerVec.begin(); cl != containerVec.end(); ++cl)
 	{
 		if(cl->second == container) {
+			CastCapture capture(this);
 			client->sendRemoveContainerItem(cl->first, slot);
-			for(AutoList<ProtocolGame>::iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it) //CAST
-				if(it->second->getPlayer() == this)
-					it->second->sendRemoveContainerItem(cl->first, slot);
 		}
 	}
 }
@@ -1656,10 +1695,8 @@ void Player::onCloseContainer(const Container* container)
 	for(ContainerVector::const_iterator cl = containerVec.begin(); cl != containerVec.end(); ++cl)
 	{
 		if(cl->second == container) {
+			CastCapture capture(this);
 			client->sendCloseContainer(cl->first);
-			for(AutoList<ProtocolGame>::iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it) //CAST
-				if(it->second->getPlayer() == this)
-					it->second->sendCloseContainer(cl->first);
 		}
 	}
 }
@@ -1673,10 +1710,8 @@ void Player::onSendContainer(const Container* container)
 	for(ContainerVector::const_iterator cl = containerVec.begin(); cl != containerVec.end(); ++cl)
 	{
 		if(cl->second == container) {
+			CastCapture capture(this);
 			client->sendContainer(cl->first, container, hasParent);
-			for(AutoList<ProtocolGame>::iterator it = Player::cSpectators.begin(); it != Player::cSpectators.end(); ++it) //CAST
-				if(it->second->getPlayer() == this)
-					it->second->sendContainer(cl->first, container, hasParent);
 		}
 	}
 }
@@ -2635,10 +2670,8 @@ void Player::autoCloseContainers(const Container* container)
 	{
 		closeContainer(*it);
 		if(client) {
+			CastCapture capture(this);
 			client->sendCloseContainer(*it);
-			for(AutoList<ProtocolGame>::iterator it2 = Player::cSpectators.begin(); it2 != Player::cSpectators.end(); ++it2) //CAST
-				if(it2->second->getPlayer() == this)
-					it2->second->sendCloseContainer(*it);
 		}
 	}
 }
@@ -3499,7 +3532,7 @@ bool Player::setAttackedCreature(Creature* creature)
 		setFollowCreature(NULL);
 
 	if(creature)
-		g_dispatcher.addTask(createTask(std::bind(&Game::checkCreatureAttack, &g_game, getID())));
+		g_dispatcher.addTask(createTaskWithOrigin("Player::setAttackedCreature", std::bind(&Game::checkCreatureAttack, &g_game, getID())));
 
 	return true;
 }
@@ -3534,7 +3567,7 @@ void Player::doAttacking(uint32_t)
 	{
 		if(_weapon->interruptSwing() && !canDoAction())
 		{
-			SchedulerTask* task = createSchedulerTask(getNextActionTime(),
+			SchedulerTask* task = createSchedulerTaskWithOrigin("Player::doAttacking", getNextActionTime(),
 				std::bind(&Game::checkCreatureAttack, &g_game, getID()));
 			setNextActionTask(task);
 		}
@@ -4341,7 +4374,7 @@ bool Player::addUnjustifiedKill(const Player* attacked, bool countNow)
 
 		sendTextMessage(MSG_INFO_DESCR, "You have been banished.");
 		g_game.addMagicEffect(getPosition(), MAGIC_EFFECT_WRAPS_GREEN);
-		g_scheduler.addEvent(createSchedulerTask(1000, std::bind(
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Player::addUnjustifiedKill", 1000, std::bind(
 			&Game::kickPlayer, &g_game, getID(), false)));
 	}
 	else
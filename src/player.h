@@ -70,6 +70,11 @@ struct PlayerCast //CAST
 	}
 };
 
+struct CastStats
+{
+	uint64_t packets{0}, bytes{0}, copies{0}, dropped{0};
+};
+
 enum skillsid_t
 {
 	SKILL_LEVEL = 0,
@@ -226,25 +231,33 @@ class Player : public Creature, public Cylinder
 			return count;
 		}
 
+		void kickCastViewer(uint32_t id) const {
+			AutoList<ProtocolGame>::iterator it = cSpectators.find(id);
+			if(it == cSpectators.end())
+				return;
+
+			it->second->disconnect();
+			it->second->unRef();
+			cSpectators.erase(it);
+		}
+
 		void kickCastViewers() {
-			for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) {
-				if(it->second->getPlayer() == this) {
-					it->second->disconnect();
-					it->second->unRef();
-					removeCastViewer(it->first);
-					//it = cSpectators.begin();
-				}
+			for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end();) {
+				if(it->second->getPlayer() == this)
+					kickCastViewer((it++)->first);
+				else
+					++it;
 			}
 			cast = PlayerCast();
 		}
 
 		void kickCastViewerByName(std::string n) {
-			for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-				if(it->second->getViewerName() == n && it->second->getPlayer() == this) {
-					it->second->disconnect();
-					it->second->unRef();
-					removeCastViewer(it->first);
-				}
+			for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end();) {
+				if(it->second->getPlayer() == this && it->second->getViewerName() == n)
+					kickCastViewer((it++)->first);
+				else
+					++it;
+			}
 		}
 
 		bool addCastKick(std::string n) {
@@ -315,6 +328,7 @@ class Player : public Creature, public Cylinder
 		static AutoList<Player> castAutoList; //CAST
 		static AutoList<ProtocolGame> cSpectators;
 		static uint32_t nextSpectator;
+		static CastStats castStats;
 		
 		virtual uint32_t rangeId() {return 0x10000000;}
 
@@ -690,37 +704,21 @@ class Player : public Creature, public Cylinder
 		//tile
 		//send methods
 		void sendAddTileItem(const Tile* tile, const Position& pos, const Item* item)
-			{if(client) {client->sendAddTileItem(tile, pos, tile->getClientIndexOfThing(this, item), item);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendAddTileItem(tile, pos, tile->getClientIndexOfThing(this, item), item);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendAddTileItem(tile, pos, tile->getClientIndexOfThing(this, item), item);}}
 
 		void sendUpdateTileItem(const Tile* tile, const Position& pos, const Item* oldItem, const Item* newItem)
-			{if(client) {client->sendUpdateTileItem(tile, pos, tile->getClientIndexOfThing(this, oldItem), newItem);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendUpdateTileItem(tile, pos, tile->getClientIndexOfThing(this, oldItem), newItem);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendUpdateTileItem(tile, pos, tile->getClientIndexOfThing(this, oldItem), newItem);}}
 		void sendRemoveTileItem(const Tile* tile, const Position& pos, uint32_t stackpos, const Item*)
-			{if(client) {client->sendRemoveTileItem(tile, pos, stackpos);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendRemoveTileItem(tile, pos, stackpos);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendRemoveTileItem(tile, pos, stackpos);}}
 		void sendUpdateTile(const Tile* tile, const Position& pos)
 			{if(client) {client->sendUpdateTile(tile, pos);
 				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
 					it->second->sendUpdateTile(tile, pos);
-			}	
+			}
 		}
 
 		void sendChannelMessage(std::string author, std::string text, SpeakClasses type, uint8_t channel)
-			{if(client) {client->sendChannelMessage(author, text, type, channel);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendChannelMessage(author, text, type, channel);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendChannelMessage(author, text, type, channel);}}
 
 		void sendCreatureAppear(const Creature* creature)
 			{if(client) {client->sendAddCreature(creature, creature->getPosition(), creature->getTile()->getClientIndexOfThing(this, creature));
@@ -729,11 +727,7 @@ class Player : public Creature, public Cylinder
 			}
 		}
 		void sendCreatureDisappear(const Creature* creature, uint32_t stackpos)
-			{if(client) {client->sendRemoveCreature(creature, creature->getPosition(), stackpos);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendRemoveCreature(creature, creature->getPosition(), stackpos); 
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendRemoveCreature(creature, creature->getPosition(), stackpos);}}
 		void sendCreatureMove(const Creature* creature, const Tile* newTile, const Position& newPos,
 			const Tile* oldTile, const Position& oldPos, uint32_t oldStackpos, bool teleport)
 			{if(client) {client->sendMoveCreature(creature, newTile, newPos, newTile->getClientIndexOfThing(this, creature), oldTile, oldPos, oldStackpos, teleport);
@@ -743,53 +737,35 @@ class Player : public Creature, public Cylinder
 		}
 
 		void sendCreatureTurn(const Creature* creature)
-			{if(client) {client->sendCreatureTurn(creature, creature->getTile()->getClientIndexOfThing(this, creature));
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureTurn(creature, creature->getTile()->getClientIndexOfThing(this, creature));
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureTurn(creature, creature->getTile()->getClientIndexOfThing(this, creature));}}
 		void sendCreatureSay(const Creature* creature, SpeakClasses type, const std::string& text, Position* pos = NULL)
 			{if(client) {client->sendCreatureSay(creature, type, text, pos);
 				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
 					it->second->sendCreatureSay(creature, type, text, pos);
 			}
 		}
-
-		void sendCreatureSquare(const Creature* creature, uint8_t color)
-			{if(client) {client->sendCreatureSquare(creature, color);
+		void sendCreatureSay(const Creature* creature, NetworkMessage_ptr packet)
+			{if(client) {client->sendCreatureSay(creature, packet);
 				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureSquare(creature, color);
+					it->second->sendCreatureSay(creature, packet);
 			}
 		}
+
+		void sendCreatureSquare(const Creature* creature, uint8_t color)
+			{if(client) {CastCapture capture(this); client->sendCreatureSquare(creature, color);}}
 		void sendCreatureChangeOutfit(const Creature* creature, const Outfit_t& outfit)
-			{if(client) {client->sendCreatureOutfit(creature, outfit);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureOutfit(creature, outfit);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureOutfit(creature, outfit);}}
 		void sendCreatureChangeVisible(const Creature* creature, Visible_t visible);
 		void sendCreatureLight(const Creature* creature)
-			{if(client) {client->sendCreatureLight(creature);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureLight(creature);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureLight(creature);}}
 		void sendCreatureShield(const Creature* creature)
-			{if(client) {client->sendCreatureShield(creature);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureShield(creature);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureShield(creature);}}
 		void sendCreatureEmblem(const Creature* creature)
-			{if(client) {client->sendCreatureEmblem(creature);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureEmblem(creature);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureEmblem(creature);}}
         void sendCreatureImpassable(const Creature* creature)
             {if(client) {client->sendCreatureImpassable(creature);
 				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureEmblem(creature);
+					it->second->sendCreatureImpassable(creature);
            }
         }
         //Opcode
@@ -805,23 +781,11 @@ class Player : public Creature, public Cylinder
 
 		//inventory
 		void sendAddInventoryItem(slots_t slot, const Item* item)
-			{if(client) {client->sendAddInventoryItem(slot, item);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendAddInventoryItem(slot, item);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendAddInventoryItem(slot, item);}}
 		void sendUpdateInventoryItem(slots_t slot, const Item*, const Item* newItem)
-			{if(client) {client->sendUpdateInventoryItem(slot, newItem);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendUpdateInventoryItem(slot, newItem);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendUpdateInventoryItem(slot, newItem);}}
 		void sendRemoveInventoryItem(slots_t slot, const Item*)
-			{if(client) {client->sendRemoveInventoryItem(slot);
-				for(AutoList<ProtocolGame>::iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendRemoveInventoryItem(slot);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendRemoveInventoryItem(slot);}}
 
 		//event methods
 		virtual void onUpdateTileItem(const Tile* tile, const Position& pos, const Item* oldItem,
@@ -866,98 +830,44 @@ class Player : public Creature, public Cylinder
 		void onRemoveInventoryItem(slots_t slot, Item* item);
 
 		void sendAnimatedText(const Position& pos, uint8_t color, std::string text) const
-			{if(client) {client->sendAnimatedText(pos,color,text);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendAnimatedText(pos,color,text);
-			}
-        }
+			{if(client) {CastCapture capture(this); client->sendAnimatedText(pos,color,text);}}
 		void sendCancel(const std::string& msg) const
-			{if(client) {client->sendCancel(msg);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCancel(msg);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCancel(msg);}}
 		void sendCancelMessage(ReturnValue message) const;
 		void sendCancelTarget() const
-			{if(client) {client->sendCancelTarget();
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCancelTarget();
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCancelTarget();}}
 		void sendCancelWalk() const
-			{if(client) {client->sendCancelWalk();
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCancelWalk();
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCancelWalk();}}
 		void sendChangeSpeed(const Creature* creature, uint32_t newSpeed) const
-			{if(client) {client->sendChangeSpeed(creature, newSpeed);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendChangeSpeed(creature, newSpeed);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendChangeSpeed(creature, newSpeed);}}
 		void sendCreatureHealth(const Creature* creature) const
-			{if(client) {client->sendCreatureHealth(creature);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureHealth(creature);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureHealth(creature);}}
 		void sendDistanceShoot(const Position& from, const Position& to, uint16_t type) const
-			{if(client) {client->sendDistanceShoot(from, to, type);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendDistanceShoot(from, to, type); 
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendDistanceShoot(from, to, type);}}
 		
 		void sendHouseWindow(House* house, uint32_t listId) const;
 		void sendOutfitWindow() const {if(client) client->sendOutfitWindow();}
 		void sendQuests() const {if(client) client->sendQuests();}
 		void sendQuestInfo(Quest* quest) const {if(client) client->sendQuestInfo(quest);}
 		void sendCreatureSkull(const Creature* creature) const
-			{if(client) {client->sendCreatureSkull(creature);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatureSkull(creature);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatureSkull(creature);}}
 		void sendFYIBox(std::string message)
 			{if(client) client->sendFYIBox(message);}
 		void sendCreatePrivateChannel(uint16_t channelId, const std::string& channelName)
-			{if(client) {client->sendCreatePrivateChannel(channelId, channelName);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCreatePrivateChannel(channelId, channelName);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCreatePrivateChannel(channelId, channelName);}}
 		void sendClosePrivate(uint16_t channelId) const
-			{if(client) {client->sendClosePrivate(channelId);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendClosePrivate(channelId);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendClosePrivate(channelId);}}
 		void sendIcons() const;
 		void sendMagicEffect(const Position& pos, uint16_t type) const
-			{if(client) {client->sendMagicEffect(pos, type);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendMagicEffect(pos, type);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendMagicEffect(pos, type);}}
+		void sendPacket(NetworkMessage_ptr packet) const
+			{if(client) {CastCapture capture(this); client->sendPacket(packet);}}
 		void sendStats() const
-			{if(client) {client->sendStats();
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendStats();
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendStats();}}
 		void sendSkills() const
-			{if(client) {client->sendSkills();
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendSkills();
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendSkills();}}
 		void sendTextMessage(MessageClasses type, const std::string& message) const
-			{if(client) {client->sendTextMessage(type, message);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendTextMessage(type, message);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendTextMessage(type, message);}}
 			
 		void sendReLoginWindow() const
 			{if(client) client->sendReLoginWindow();}
@@ -982,11 +892,7 @@ class Player : public Creature, public Cylinder
 		void sendTradeClose() const
 			{if(client) client->sendCloseTrade();}
 		void sendWorldLight(LightInfo& lightInfo)
-			{if(client) {client->sendWorldLight(lightInfo);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendWorldLight(lightInfo);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendWorldLight(lightInfo);}}
 		void sendChannelsDialog()
 			{if(client) client->sendChannelsDialog();}
 		void sendOpenPrivateChannel(const std::string& receiver)
@@ -994,17 +900,9 @@ class Player : public Creature, public Cylinder
 		void sendOutfitWindow()
 			{if(client) client->sendOutfitWindow();}
 		void sendCloseContainer(uint32_t cid)
-			{if(client) {client->sendCloseContainer(cid);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendCloseContainer(cid);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendCloseContainer(cid);}}
 		void sendChannel(uint16_t channelId, const std::string& channelName)
-			{if(client) {client->sendChannel(channelId, channelName);
-				for(AutoList<ProtocolGame>::const_iterator it = cSpectators.begin(); it != cSpectators.end(); ++it) if(it->second->getPlayer() == this)
-					it->second->sendChannel(channelId, channelName);
-			}
-		}
+			{if(client) {CastCapture capture(this); client->sendChannel(channelId, channelName);}}
 			
 		void sendRuleViolationsChannel(uint16_t channelId)
 			{if(client) client->sendRuleViolationsChannel(channelId);}
@@ -1065,6 +963,23 @@ class Player : public Creature, public Cylinder
 
 	protected:
         PlayerCast cast; //CAST
+
+		// copies what one send serialized into the client's output message to
+		// every viewer of the cast, so that viewers only cost the encryption
+		// of their own connection
+		class CastCapture
+		{
+			public:
+				CastCapture(const Player* player);
+				~CastCapture();
+
+			private:
+				const Player* m_player;
+				OutputMessage_ptr m_msg;
+				uint16_t m_start;
+		};
+		mutable uint32_t castCaptureDepth;
+		void sendCastData(const char* data, uint16_t size) const;
               
 		void checkTradeState(const Item* item);
 
@@ -22,6 +22,7 @@
 #include "connection.h"
 #include "outputmessage.h"
 
+#include "netcrypto.h"
 #include "rsa.h"
 #include "scheduler.h"
 
@@ -107,7 +108,7 @@ OutputMessage_ptr Protocol::getOutputBuffer()
 void Protocol::releaseProtocol()
 {
 	if(m_refCount > 0)
-		g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, std::bind(&Protocol::releaseProtocol, this)));
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("Protocol::releaseProtocol", SCHEDULER_MINTICKS, std::bind(&Protocol::releaseProtocol, this)));
 	else
 		deleteProtocolTask();
 }
@@ -122,10 +123,6 @@ void Protocol::deleteProtocolTask()
 
 void Protocol::XTEA_encrypt(OutputMessage& msg)
 {
-	uint32_t k[4];
-	for(uint8_t i = 0; i < 4; i++)
-		k[i] = m_key[i];
-
 	int32_t messageLength = msg.size();
 	//add bytes until reach 8 multiple
 	uint32_t n;
@@ -136,22 +133,7 @@ void Protocol::XTEA_encrypt(OutputMessage& msg)
 		messageLength = messageLength + n;
 	}
 
-	int32_t readPos = 0;
-	uint32_t* buffer = (uint32_t*)msg.getOutputBuffer();
-	while(readPos < messageLength / 4)
-	{
-		uint32_t v0 = buffer[readPos], v1 = buffer[readPos + 1], delta = 0x61C88647, sum = 0;
-		for(int32_t i = 0; i < 32; i++)
-		{
-			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-			sum -= delta;
-			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[sum>>11 & 3]);
-		}
-
-		buffer[readPos] = v0;
-		buffer[readPos + 1] = v1;
-		readPos += 2;
-	}
+	xteaEncrypt((uint32_t*)msg.getOutputBuffer(), messageLength / 8, m_key);
 }
 
 bool Protocol::XTEA_decrypt(NetworkMessage& msg)
@@ -167,26 +149,8 @@ bool Protocol::XTEA_decrypt(NetworkMessage& msg)
 		return false;
 	}
 
-	uint32_t k[4];
-	for(uint8_t i = 0; i < 4; i++)
-		k[i] = m_key[i];
-
-	int32_t messageLength = msg.size() - 6, readPos = 0;
-	uint32_t* buffer = (uint32_t*)(msg.buffer() + msg.position());
-	while(readPos < messageLength / 4)
-	{
-		uint32_t v0 = buffer[readPos], v1 = buffer[readPos + 1], delta = 0x61C88647, sum = 0xC6EF3720;
-		for(int32_t i = 0; i < 32; i++)
-		{
-			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[sum >> 11 & 3]);
-			sum += delta;
-			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-		}
-
-		buffer[readPos] = v0;
-		buffer[readPos + 1] = v1;
-		readPos += 2;
-	}
+	int32_t messageLength = msg.size() - 6;
+	xteaDecrypt((uint32_t*)(msg.buffer() + msg.position()), messageLength / 8, m_key);
 
 	int32_t tmp = msg.get<uint16_t>();
 	if(tmp > msg.size() - 8)
@@ -44,6 +44,8 @@ class Protocol
 
 		virtual void onConnect() {}
 		virtual void onRecvFirstMessage(NetworkMessage& msg) = 0;
+		// the first message carries an RSA block, so it goes through the crypto workers
+		virtual bool hasEncryptedFirstMessage() const {return false;}
 
 		void onRecvMessage(NetworkMessage& msg);
 		void onSendMessage(OutputMessage_ptr msg);
@@ -50,12 +50,12 @@ extern CreatureEvents* g_creatureEvents;
 extern Chat g_chat;
 
 template<class FunctionType>
-void ProtocolGame::addGameTaskInternal(uint32_t delay, const FunctionType& func)
+void ProtocolGame::addGameTaskInternal(const char* origin, uint32_t delay, FunctionType&& func)
 {
 	if(delay > 0)
-		g_dispatcher.addTask(createTask(delay, func));
+		g_dispatcher.addTask(createTaskWithOrigin(origin, delay, std::forward<FunctionType>(func)));
 	else
-		g_dispatcher.addTask(createTask(func));
+		g_dispatcher.addTask(createTaskWithOrigin(origin, std::forward<FunctionType>(func)));
 }
 
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
@@ -282,7 +282,7 @@ bool ProtocolGame::login(const std::string& name, uint32_t id, const std::string
 
 		addRef();
 		if(!castAccount)
-			m_eventConnect = g_scheduler.addEvent(createSchedulerTask(
+			m_eventConnect = g_scheduler.addEvent(createSchedulerTaskWithOrigin("ProtocolGame::login",
 				1000, std::bind(&ProtocolGame::connect, this, _player->getID(), operatingSystem, version, castAccount)));
 		else
 			connect(_player->getID(), operatingSystem, version, castAccount);
@@ -607,7 +607,7 @@ bool ProtocolGame::parseFirstPacket(NetworkMessage& msg)
 	}
 
 	ConnectionManager::getInstance()->addAttempt(getIP(), protocolId, true);
-	g_dispatcher.addTask(createTask(std::bind(
+	g_dispatcher.addTask(createTaskWithOrigin("ProtocolGame::parseFirstPacket", std::bind(
 		&ProtocolGame::login, this, character, id, password, operatingSystem, version, gamemaster, castAccount)));
 	return true;
 }
@@ -959,7 +959,7 @@ void ProtocolGame::parsePacket(NetworkMessage &msg)
 						player->sendTextMessage(MSG_INFO_DESCR, "You have been banished.");
 
 						g_game.addMagicEffect(player->getPosition(), MAGIC_EFFECT_WRAPS_GREEN);
-						g_scheduler.addEvent(createSchedulerTask(1000, std::bind(
+						g_scheduler.addEvent(createSchedulerTaskWithOrigin("ProtocolGame::parsePacket", 1000, std::bind(
 							&Game::kickPlayer, &g_game, player->getID(), false)));
 					}
 				}
@@ -979,23 +979,15 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
 	if(!tile)
 		return;
 
-	int32_t count = 0;
-	if(tile->ground)
-	{
-		msg->putItem(tile->ground);
-		count++;
-	}
+	//the items are copied as the tile last serialized them, only creatures
+	//depend on who is looking
+	const uint8_t* description = tile->getDescription();
+	const char* items = (const char*)description + TILEDESC_DOWNENDS + description[TILEDESC_DOWNCOUNT];
 
-	const TileItemVector* items = tile->getItemList();
-	const CreatureVector* creatures = tile->getCreatures();
-
-	ItemVector::const_iterator it;
-	if(items)
-	{
-		for(it = items->getBeginTopItem(); (it != items->getEndTopItem() && count < 10); ++it, ++count)
-			msg->putItem(*it);
-	}
+	int32_t count = description[TILEDESC_TOPCOUNT];
+	msg->putBytes(items, description[TILEDESC_TOPSIZE]);
 
+	const CreatureVector* creatures = tile->getCreatures();
 	if(creatures)
 	{
 		for(CreatureVector::const_reverse_iterator cit = creatures->rbegin(); (cit != creatures->rend() && count < 10); ++cit)
@@ -1012,11 +1004,9 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
 		}
 	}
 
-	if(items)
-	{
-		for(it = items->getBeginDownItem(); (it != items->getEndDownItem() && count < 10); ++it, ++count)
-			msg->putItem(*it);
-	}
+	int32_t downCount = std::min((int32_t)description[TILEDESC_DOWNCOUNT], 10 - count);
+	if(downCount > 0)
+		msg->putBytes(items + description[TILEDESC_TOPSIZE], description[TILEDESC_DOWNENDS + downCount - 1]);
 }
 
 void ProtocolGame::GetMapDescription(int32_t x, int32_t y, int32_t z,
@@ -1160,7 +1150,7 @@ bool ProtocolGame::canSee(uint16_t x, uint16_t y, uint16_t z) const
 //********************** Parse methods *******************************//
 void ProtocolGame::parseLogout(NetworkMessage&)
 {
-	g_dispatcher.addTask(createTask(std::bind(&ProtocolGame::logout, this, true, false)));
+	g_dispatcher.addTask(createTaskWithOrigin("ProtocolGame::parseLogout", std::bind(&ProtocolGame::logout, this, true, false)));
 }
 
 void ProtocolGame::parseCreatePrivateChannel(NetworkMessage&)
@@ -2277,6 +2267,84 @@ void ProtocolGame::sendAnimatedText(const Position& pos, uint8_t color, std::str
 	}
 }
 
+NetworkMessage_ptr ProtocolGame::getBroadcastMessage()
+{
+	//dispatcher thread only, a broadcast is copied out before the next one is created
+	static NetworkMessage_ptr broadcast(new NetworkMessage());
+	broadcast->reset(0);
+	return broadcast;
+}
+
+NetworkMessage_ptr ProtocolGame::createAnimatedText(const Position& pos, uint8_t color, const std::string& text)
+{
+	NetworkMessage_ptr packet = getBroadcastMessage();
+	AddAnimatedText(packet, pos, color, text);
+	return packet;
+}
+
+NetworkMessage_ptr ProtocolGame::createMagicEffect(const Position& pos, uint16_t type)
+{
+	NetworkMessage_ptr packet = getBroadcastMessage();
+	AddMagicEffect(packet, pos, type);
+	return packet;
+}
+
+NetworkMessage_ptr ProtocolGame::createDistanceShoot(const Position& from, const Position& to, uint16_t type)
+{
+	NetworkMessage_ptr packet = getBroadcastMessage();
+	AddDistanceShoot(packet, from, to, type);
+	return packet;
+}
+
+NetworkMessage_ptr ProtocolGame::createCreatureSay(const Creature* creature, SpeakClasses type,
+	const std::string& text, Position* pos/* = NULL*/)
+{
+	NetworkMessage_ptr packet = getBroadcastMessage();
+	AddCreatureSpeak(packet, creature, type, text, 0, 0, pos, NULL);
+	return packet;
+}
+
+void ProtocolGame::sendPacket(NetworkMessage_ptr packet)
+{
+	NetworkMessage_ptr msg = getOutputBuffer();
+	if(msg)
+	{
+		TRACK_MESSAGE(msg);
+		msg->putBytes(packet->buffer(), packet->size());
+	}
+}
+
+bool ProtocolGame::sendCastData(const char* data, uint16_t size)
+{
+	//a stalled viewer keeps its output message, so it is checked on every copy
+	int64_t stall = g_config.getNumber(ConfigManager::CAST_VIEWER_STALL);
+	if(stall)
+	{
+		if(Connection_ptr connection = getConnection())
+		{
+			if(connection->getWriteStall() > stall)
+				return false;
+		}
+	}
+
+	NetworkMessage_ptr msg = getOutputBuffer();
+	if(msg)
+	{
+		TRACK_MESSAGE(msg);
+		msg->putBytes(data, size);
+	}
+
+	return true;
+}
+
+void ProtocolGame::sendCreatureSay(const Creature* creature, NetworkMessage_ptr packet)
+{
+	if(isCast && !(creature->getPlayer() == player)) //CAST
+		return;
+
+	sendPacket(packet);
+}
+
 void ProtocolGame::sendCreatureHealth(const Creature* creature)
 {
 	if(!canSee(creature))
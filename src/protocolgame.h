@@ -88,6 +88,15 @@ class ProtocolGame : public Protocol
 			sendCreatePrivateChannel(channelId, channelName);
 		}
 
+		// events every spectator sees alike are serialized once by the create
+		// functions, into a shared buffer that stays valid until the next one
+		// is created, and copied from it into each viewer's output message
+		static NetworkMessage_ptr createAnimatedText(const Position& pos, uint8_t color, const std::string& text);
+		static NetworkMessage_ptr createMagicEffect(const Position& pos, uint16_t type);
+		static NetworkMessage_ptr createDistanceShoot(const Position& from, const Position& to, uint16_t type);
+		static NetworkMessage_ptr createCreatureSay(const Creature* creature, SpeakClasses type,
+			const std::string& text, Position* pos = NULL);
+
 	private:
 		void disconnectClient(uint8_t error, const char* message);
 
@@ -106,6 +115,7 @@ class ProtocolGame : public Protocol
 
 		virtual void onConnect();
 		virtual void onRecvFirstMessage(NetworkMessage& msg);
+		virtual bool hasEncryptedFirstMessage() const {return true;}
 
 		bool parseFirstPacket(NetworkMessage& msg);
 		virtual void parsePacket(NetworkMessage& msg);
@@ -210,6 +220,11 @@ class ProtocolGame : public Protocol
 		void sendCreatureTurn(const Creature* creature, int16_t stackpos);
 		void sendCreatureSay(const Creature* creature, SpeakClasses type, const std::string& text, Position* pos = NULL);
 
+		void sendPacket(NetworkMessage_ptr packet);
+		// false once this viewer's client has stalled a write for more than castViewerStall
+		bool sendCastData(const char* data, uint16_t size);
+		void sendCreatureSay(const Creature* creature, NetworkMessage_ptr packet);
+
 		void sendCancel(const std::string& message);
 		void sendCancelWalk();
 		void sendChangeSpeed(const Creature* creature, uint32_t speed);
@@ -288,14 +303,16 @@ class ProtocolGame : public Protocol
 		void GetMapDescription(int32_t x, int32_t y, int32_t z,
 			int32_t width, int32_t height, NetworkMessage_ptr msg);
 
+		static NetworkMessage_ptr getBroadcastMessage();
+
 		void AddMapDescription(NetworkMessage_ptr msg, const Position& pos);
 		void AddTextMessage(NetworkMessage_ptr msg, MessageClasses mclass, const std::string& message);
-		void AddAnimatedText(NetworkMessage_ptr msg, const Position& pos, uint8_t color, const std::string& text);
-		void AddMagicEffect(NetworkMessage_ptr msg, const Position& pos, uint16_t type);
-		void AddDistanceShoot(NetworkMessage_ptr msg, const Position& from, const Position& to, uint16_t type);
+		static void AddAnimatedText(NetworkMessage_ptr msg, const Position& pos, uint8_t color, const std::string& text);
+		static void AddMagicEffect(NetworkMessage_ptr msg, const Position& pos, uint16_t type);
+		static void AddDistanceShoot(NetworkMessage_ptr msg, const Position& from, const Position& to, uint16_t type);
 		void AddCreature(NetworkMessage_ptr msg, const Creature* creature, bool known, uint32_t remove);
 		void AddPlayerStats(NetworkMessage_ptr msg);
-		void AddCreatureSpeak(NetworkMessage_ptr msg, const Creature* creature, SpeakClasses type,
+		static void AddCreatureSpeak(NetworkMessage_ptr msg, const Creature* creature, SpeakClasses type,
 			std::string text, uint16_t channelId, uint32_t time = 0, Position* pos = NULL, ProtocolGame* pg = NULL); //CAST
 		void AddCreatureHealth(NetworkMessage_ptr msg, const Creature* creature);
 		void AddCreatureOutfit(NetworkMessage_ptr msg, const Creature* creature, const Outfit_t& outfit, bool outfitWindow = false);
@@ -330,10 +347,10 @@ class ProtocolGame : public Protocol
 		void parseExtendedOpcode(NetworkMessage& msg);
         void sendExtendedOpcode(uint8_t opcode, const std::string& buffer);
 
-		#define addGameTask(f, ...) addGameTaskInternal(0, std::bind(f, &g_game, __VA_ARGS__))
-		#define addGameTaskTimed(delay, f, ...) addGameTaskInternal(delay, std::bind(f, &g_game, __VA_ARGS__))
+		#define addGameTask(f, ...) addGameTaskInternal(#f, 0, std::bind(f, &g_game, __VA_ARGS__))
+		#define addGameTaskTimed(delay, f, ...) addGameTaskInternal(#f, delay, std::bind(f, &g_game, __VA_ARGS__))
 		template<class FunctionType>
-		void addGameTaskInternal(uint32_t delay, const FunctionType&);
+		void addGameTaskInternal(const char* origin, uint32_t delay, FunctionType&& func);
 
 		friend class Player;
 		Player* player;
@@ -28,6 +28,7 @@ class ProtocolLogin : public Protocol
 		static uint32_t protocolLoginCount;
 #endif
 		virtual void onRecvFirstMessage(NetworkMessage& msg) {parseFirstPacket(msg);}
+		virtual bool hasEncryptedFirstMessage() const {return true;}
 
 		ProtocolLogin(Connection_ptr connection) : Protocol(connection)
 		{
@@ -27,6 +27,7 @@ class ProtocolOld : public Protocol
 		static uint32_t protocolOldCount;
 #endif
 		virtual void onRecvFirstMessage(NetworkMessage& msg);
+		virtual bool hasEncryptedFirstMessage() const {return true;}
 
 		ProtocolOld(Connection_ptr connection): Protocol(connection)
 		{
@@ -154,7 +154,7 @@ bool Raids::startup()
 		return false;
 
 	setLastRaidEnd(OTSYS_TIME());
-	checkRaidsEvent = g_scheduler.addEvent(createSchedulerTask(
+	checkRaidsEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Raids::startup",
 		CHECK_RAIDS_INTERVAL * 1000, std::bind(&Raids::checkRaids, this)));
 
 	started = true;
@@ -163,7 +163,7 @@ bool Raids::startup()
 
 void Raids::checkRaids()
 {
-	checkRaidsEvent = g_scheduler.addEvent(createSchedulerTask(
+	checkRaidsEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Raids::checkRaids",
 		CHECK_RAIDS_INTERVAL * 1000, std::bind(&Raids::checkRaids, this)));
 	if(running)
 		return;
@@ -298,7 +298,7 @@ bool Raid::startRaid()
 	if(!raidEvent)
 		return false;
 
-	nextEvent = g_scheduler.addEvent(createSchedulerTask(
+	nextEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Raid::startRaid",
 		raidEvent->getDelay(), std::bind(&Raid::executeRaidEvent, this, raidEvent)));
 	Raids::getInstance()->setRunning(this);
 	return true;
@@ -313,7 +313,7 @@ bool Raid::executeRaidEvent(RaidEvent* raidEvent)
 	if(!newRaidEvent)
 		return !resetRaid(false);
 
-	nextEvent = g_scheduler.addEvent(createSchedulerTask(
+	nextEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Raid::executeRaidEvent",
 		std::max(RAID_MINTICKS, (int32_t)(newRaidEvent->getDelay() - raidEvent->getDelay())),
 		std::bind(&Raid::executeRaidEvent, this, newRaidEvent)));
 	return true;
@@ -22,7 +22,8 @@
 #include <cryptopp/base64.h>
 #include <cryptopp/osrng.h>
 
-static CryptoPP::AutoSeededRandomPool prng;
+// the pool is not thread-safe and logins are decrypted on every network thread
+static thread_local CryptoPP::AutoSeededRandomPool prng;
 
 void RSA::decrypt(char* msg) const
 {
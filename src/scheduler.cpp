@@ -20,6 +20,14 @@
 
 #include "tools.h"
 
+Scheduler::Scheduler()
+{
+	m_startTime = std::chrono::system_clock::now();
+	std::fill(std::begin(m_root), std::end(m_root), (SchedulerTask*)NULL);
+	for(uint32_t level = 0; level < SCHEDULER_LEVELS; ++level)
+		std::fill(std::begin(m_levels[level]), std::end(m_levels[level]), (SchedulerTask*)NULL);
+}
+
 void Scheduler::threadMain()
 {
 	#if defined __EXCEPTION_TRACER__
@@ -27,87 +35,248 @@ void Scheduler::threadMain()
 		schedulerExceptionHandler.InstallHandler();
 	#endif
 
-	std::unique_lock<std::mutex> eventLockUnique(m_eventLock, std::defer_lock);
+	std::unique_lock<std::mutex> eventLockUnique(m_eventLock);
 	while(m_threadState != STATE_TERMINATED)
 	{
-		SchedulerTask* task = NULL;
-		bool run = false;
-		std::cv_status ret = std::cv_status::no_timeout;
+		if(!m_readyList.empty())
+		{
+			SchedulerTask* task = m_readyList.front();
+			if(!task->m_stopped && task->getCycle() > std::chrono::system_clock::now())
+			{
+				// wait for its exact time, an earlier event may be added meanwhile
+				m_eventSignal.wait_until(eventLockUnique, task->getCycle());
+				continue;
+			}
+
+			m_readyList.pop_front();
+			if(task->m_stopped)
+			{
+				delete task;
+				continue;
+			}
+
+			m_eventIds.erase(task->getEventId());
+			eventLockUnique.unlock();
+
+			task->unsetExpiration();
+			g_dispatcher.addTask(task);
+
+			eventLockUnique.lock();
+			continue;
+		}
 
-		// check if there are events waiting...
-		eventLockUnique.lock();
-		if(m_eventList.empty()) // unlock mutex and wait for signal
+		if(m_eventIds.empty())
+		{
+			m_wakeTick = std::numeric_limits<uint64_t>::max();
 			m_eventSignal.wait(eventLockUnique);
-		else // unlock mutex and wait for signal or timeout
-			ret = m_eventSignal.wait_until(eventLockUnique, m_eventList.top()->getCycle());
+			m_wakeTick = 0;
+			continue;
+		}
 
-		// the mutex is locked again now...
-		if(ret == std::cv_status::timeout && m_threadState != STATE_TERMINATED)
+		// move everything that is due in the elapsed ticks to the ready list,
+		// empty ticks are not waited for one by one
+		uint64_t tick = getTick(std::chrono::system_clock::now()), next = getNextTick();
+		if(next <= tick)
+			advance(tick);
+		else
 		{
-			// ok we had a timeout, so there has to be an event we have to execute...
-			task = m_eventList.top();
-			m_eventList.pop();
+			m_wakeTick = next;
+			m_eventSignal.wait_until(eventLockUnique, getTickTime(next));
+			m_wakeTick = 0;
+		}
+	}
+
+	#if defined __EXCEPTION_TRACER__
+		schedulerExceptionHandler.RemoveHandler();
+	#endif
+}
+
+uint64_t Scheduler::getTick(const std::chrono::system_clock::time_point& time) const
+{
+	int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(time - m_startTime).count();
+	if(ms < 0)
+		return 0;
+
+	return (uint64_t)ms / SCHEDULER_MINTICKS;
+}
+
+std::chrono::system_clock::time_point Scheduler::getTickTime(uint64_t tick) const
+{
+	return m_startTime + std::chrono::milliseconds(tick * SCHEDULER_MINTICKS);
+}
 
-			// check if the event was stopped
-			EventIds::iterator it = m_eventIds.find(task->getEventId());
-			if(it != m_eventIds.end())
+void Scheduler::link(SchedulerTask* task)
+{
+	if(task->m_tick < m_currentTick)
+	{
+		addReady(task);
+		return;
+	}
+
+	SchedulerTask** slot = NULL;
+	uint64_t diff = task->m_tick - m_currentTick;
+	if(diff < SCHEDULER_ROOT_SIZE)
+		slot = &m_root[task->m_tick & (SCHEDULER_ROOT_SIZE - 1)];
+	else
+	{
+		uint64_t tick = task->m_tick;
+		for(uint32_t level = 0; level < SCHEDULER_LEVELS; ++level)
+		{
+			uint32_t shift = SCHEDULER_ROOT_BITS + level * SCHEDULER_LEVEL_BITS;
+			if(level == SCHEDULER_LEVELS - 1)
 			{
-				// was not stopped so we should run it
-				run = true;
-				m_eventIds.erase(it);
+				// beyond the wheel range, it is cascaded again once the last level wraps
+				if(diff > 0xFFFFFFFF)
+					tick = m_currentTick + 0xFFFFFFFF;
 			}
+			else if(diff >= (1ULL << (shift + SCHEDULER_LEVEL_BITS)))
+				continue;
+
+			slot = &m_levels[level][(tick >> shift) & (SCHEDULER_LEVEL_SIZE - 1)];
+			break;
 		}
+	}
+
+	task->m_slot = slot;
+	task->m_slotPrev = NULL;
+	task->m_slotNext = *slot;
+	if(*slot)
+		(*slot)->m_slotPrev = task;
+
+	*slot = task;
+}
+
+void Scheduler::unlink(SchedulerTask* task)
+{
+	if(task->m_slotPrev)
+		task->m_slotPrev->m_slotNext = task->m_slotNext;
+	else
+		*task->m_slot = task->m_slotNext;
+
+	if(task->m_slotNext)
+		task->m_slotNext->m_slotPrev = task->m_slotPrev;
+
+	task->m_slot = NULL;
+	task->m_slotPrev = task->m_slotNext = NULL;
+}
+
+bool Scheduler::cascade(uint32_t level)
+{
+	uint32_t index = (m_currentTick >> (SCHEDULER_ROOT_BITS + level * SCHEDULER_LEVEL_BITS)) & (SCHEDULER_LEVEL_SIZE - 1);
+	SchedulerTask* task = m_levels[level][index];
+
+	m_levels[level][index] = NULL;
+	while(task)
+	{
+		SchedulerTask* next = task->m_slotNext;
+		link(task);
+		task = next;
+	}
+
+	// the upper level has to be cascaded as well when this one wrapped around
+	return index != 0;
+}
 
-		eventLockUnique.unlock();
-		// add task to dispatcher
-		if(task)
+void Scheduler::advance(uint64_t tick)
+{
+	while(m_currentTick <= tick)
+	{
+		uint32_t index = m_currentTick & (SCHEDULER_ROOT_SIZE - 1);
+		if(!index)
 		{
-			// if it was not stopped
-			if(run)
+			for(uint32_t level = 0; level < SCHEDULER_LEVELS; ++level)
 			{
-				task->unsetExpiration();
-				g_dispatcher.addTask(task);
+				if(cascade(level))
+					break;
 			}
-			else
-				delete task; // was stopped, have to be deleted here
+		}
+
+		++m_currentTick;
+		SchedulerTask* task = m_root[index];
+
+		m_root[index] = NULL;
+		while(task)
+		{
+			SchedulerTask* next = task->m_slotNext;
+			task->m_slot = NULL;
+			task->m_slotPrev = task->m_slotNext = NULL;
+
+			addReady(task);
+			task = next;
 		}
 	}
+}
 
-	#if defined __EXCEPTION_TRACER__
-		schedulerExceptionHandler.RemoveHandler();
-	#endif
+uint64_t Scheduler::getNextTick() const
+{
+	bool upper = false;
+	for(uint32_t level = 0; level < SCHEDULER_LEVELS && !upper; ++level)
+	{
+		for(uint32_t i = 0; i < SCHEDULER_LEVEL_SIZE && !upper; ++i)
+			upper = m_levels[level][i] != NULL;
+	}
+
+	uint64_t tick = m_currentTick;
+	for(uint64_t end = m_currentTick + SCHEDULER_ROOT_SIZE; tick < end; ++tick)
+	{
+		uint32_t index = tick & (SCHEDULER_ROOT_SIZE - 1);
+		if(m_root[index] || (!index && upper))
+			break;
+	}
+
+	return tick;
+}
+
+void Scheduler::addReady(SchedulerTask* task)
+{
+	// only a handful of tasks are due per tick, keep them sorted by their exact time
+	std::deque<SchedulerTask*>::iterator it = m_readyList.end();
+	while(it != m_readyList.begin() && (*(it - 1))->getCycle() > task->getCycle())
+		--it;
+
+	m_readyList.insert(it, task);
 }
 
 uint32_t Scheduler::addEvent(SchedulerTask* task)
 {
 	bool signal = false;
 	m_eventLock.lock();
-	if(m_threadState == STATE_RUNNING)
+	if(m_threadState != STATE_RUNNING)
 	{
-		// check if the event has a valid id
-		if(!task->getEventId())
-		{
-			// if not generate one
-			if(m_lastEvent >= 0xFFFFFFFF)
-				m_lastEvent = 0;
+		m_eventLock.unlock();
+		#ifdef __DEBUG_SCHEDULER__
+		std::clog << "[Error - Scheduler::addTask] Scheduler thread is terminated." << std::endl;
+		#endif
+		delete task;
+		return 0;
+	}
 
-			++m_lastEvent;
-			task->setEventId(m_lastEvent);
-		}
+	// check if the event has a valid id
+	if(!task->getEventId())
+	{
+		// if not generate one
+		if(m_lastEvent >= 0xFFFFFFFF)
+			m_lastEvent = 0;
 
-		// insert the eventid in the list of active events
-		m_eventIds.insert(task->getEventId());
-		// add the event to the queue
-		m_eventList.push(task);
+		++m_lastEvent;
+		task->setEventId(m_lastEvent);
+	}
 
-		// if the list was empty or this event is the top in the list
-		// we have to signal it
-		signal = (task == m_eventList.top());
+	if(m_eventIds.empty() && m_readyList.empty())
+	{
+		// the wheel is empty, there is no need to walk through the idle ticks
+		m_currentTick = std::max(m_currentTick, getTick(std::chrono::system_clock::now()));
+		signal = true;
 	}
-#ifdef __DEBUG_SCHEDULER__
-	else
-		std::clog << "[Error - Scheduler::addTask] Scheduler thread is terminated." << std::endl;
-#endif
+
+	// insert the eventid in the list of active events
+	m_eventIds[task->getEventId()] = task;
+	task->m_tick = getTick(task->getCycle());
+
+	link(task);
+	// if this event is the next one to run we have to signal it
+	if(task->m_slot ? task->m_tick < m_wakeTick : m_readyList.front() == task)
+		signal = true;
 
 	m_eventLock.unlock();
 	if(signal)
@@ -121,20 +290,23 @@ bool Scheduler::stopEvent(uint32_t eventId)
 	if(!eventId)
 		return false;
 
-	m_eventLock.lock();
-	// search the event id...
+	std::lock_guard<std::mutex> lockClass(m_eventLock);
 	EventIds::iterator it = m_eventIds.find(eventId);
-	if(it != m_eventIds.end())
+	if(it == m_eventIds.end())
+		return false; // this eventid is not valid
+
+	SchedulerTask* task = it->second;
+	m_eventIds.erase(it);
+	if(task->m_slot)
 	{
-		// if it is found erase from the list
-		m_eventIds.erase(it);
-		m_eventLock.unlock();
-		return true;
+		// still in the wheel, drop it right away
+		unlink(task);
+		delete task;
 	}
+	else // already in the ready list, will be deleted there
+		task->m_stopped = true;
 
-	// this eventid is not valid
-	m_eventLock.unlock();
-	return false;
+	return true;
 }
 
 void Scheduler::stop()
@@ -148,18 +320,21 @@ void Scheduler::shutdown()
 {
 	m_eventLock.lock();
 	m_threadState = STATE_TERMINATED;
-	//this list should already be empty
-	while(!m_eventList.empty())
-		m_eventList.pop();
+	for(EventIds::iterator it = m_eventIds.begin(); it != m_eventIds.end(); ++it)
+	{
+		if(!it->second->m_slot)
+			continue;
+
+		unlink(it->second);
+		delete it->second;
+	}
+
+	for(std::deque<SchedulerTask*>::iterator it = m_readyList.begin(); it != m_readyList.end(); ++it)
+		delete (*it);
 
+	m_readyList.clear();
 	m_eventIds.clear();
+
 	m_eventLock.unlock();
+	m_eventSignal.notify_one();
 }
-
-SchedulerTask* createSchedulerTask(uint32_t delay, std::function<void (void)> f)
-{
-	if(delay < SCHEDULER_MINTICKS)
-		delay = SCHEDULER_MINTICKS;
-
-	return new SchedulerTask(delay, std::move(f));
-}
\ No newline at end of file
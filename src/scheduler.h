@@ -22,6 +22,13 @@
 
 static constexpr int32_t SCHEDULER_MINTICKS = 50;
 
+// hierarchical timing wheel, one tick is SCHEDULER_MINTICKS milliseconds
+static constexpr uint32_t SCHEDULER_ROOT_BITS = 8;
+static constexpr uint32_t SCHEDULER_LEVEL_BITS = 6;
+static constexpr uint32_t SCHEDULER_LEVELS = 4;
+static constexpr uint32_t SCHEDULER_ROOT_SIZE = 1 << SCHEDULER_ROOT_BITS;
+static constexpr uint32_t SCHEDULER_LEVEL_SIZE = 1 << SCHEDULER_LEVEL_BITS;
+
 class SchedulerTask : public Task
 {
 	public:
@@ -36,23 +43,39 @@ class SchedulerTask : public Task
 	protected:
 		uint32_t m_eventId = 0;
 
-		SchedulerTask(uint32_t delay, std::function<void (void)>&& f) : Task(delay, std::move(f)) {}
-		friend SchedulerTask* createSchedulerTask(uint32_t, std::function<void (void)>);
+		// wheel slot the task is linked into, NULL while it waits in the ready list
+		SchedulerTask** m_slot = NULL;
+		SchedulerTask* m_slotPrev = NULL;
+		SchedulerTask* m_slotNext = NULL;
+		uint64_t m_tick = 0;
+		bool m_stopped = false;
+
+		template<typename F>
+		SchedulerTask(uint32_t delay, F&& f) : Task(delay, std::forward<F>(f)) {}
+		template<typename F>
+		friend SchedulerTask* createSchedulerTaskWithOrigin(const char*, uint32_t, F&&);
+		friend class Scheduler;
 };
 
-SchedulerTask* createSchedulerTask(uint32_t delay, std::function<void (void)> f);
+static_assert(sizeof(SchedulerTask) <= TASK_POOL_BLOCK_SIZE, "TASK_POOL_BLOCK_SIZE is too small");
 
-struct lessTask
+template<typename F>
+inline SchedulerTask* createSchedulerTaskWithOrigin(const char* origin, uint32_t delay, F&& f)
 {
-	bool operator()(const SchedulerTask* lhs, const SchedulerTask* rhs) const {
-		return lhs->getCycle() > rhs->getCycle();
-	}
-};
+	if(delay < SCHEDULER_MINTICKS)
+		delay = SCHEDULER_MINTICKS;
 
-typedef std::set<uint32_t> EventIds;
+	SchedulerTask* task = new SchedulerTask(delay, std::forward<F>(f));
+	task->setOrigin(origin);
+	return task;
+}
+
+typedef std::unordered_map<uint32_t, SchedulerTask*> EventIds;
 class Scheduler : public ThreadHolder<Scheduler>
 {
 	public:
+		Scheduler();
+
 		uint32_t addEvent(SchedulerTask* task);
 		bool stopEvent(uint32_t eventId);
 
@@ -61,15 +84,37 @@ class Scheduler : public ThreadHolder<Scheduler>
 
 		void threadMain();
 
+		size_t getEventCount() const {return m_eventIds.size();}
+
 	protected:
+		uint64_t getTick(const std::chrono::system_clock::time_point& time) const;
+		std::chrono::system_clock::time_point getTickTime(uint64_t tick) const;
+
+		void link(SchedulerTask* task);
+		void unlink(SchedulerTask* task);
 
-		uint32_t m_lastEvent;
+		bool cascade(uint32_t level);
+		void advance(uint64_t tick);
+		// first tick from the current one that has to be advanced through, that is
+		// one with a task in its root slot or a cascade of a non-empty upper level
+		uint64_t getNextTick() const;
+		void addReady(SchedulerTask* task);
+
+		uint32_t m_lastEvent = 0;
 		EventIds m_eventIds;
 
 		std::mutex m_eventLock;
 		std::condition_variable m_eventSignal;
 
-		std::priority_queue<SchedulerTask*, std::vector<SchedulerTask*>, lessTask > m_eventList;		
+		std::chrono::system_clock::time_point m_startTime;
+		uint64_t m_currentTick = 0;
+		// tick the thread sleeps until, addEvent wakes it for anything earlier
+		uint64_t m_wakeTick = 0;
+
+		SchedulerTask* m_root[SCHEDULER_ROOT_SIZE];
+		SchedulerTask* m_levels[SCHEDULER_LEVELS][SCHEDULER_LEVEL_SIZE];
+		// tasks due in the current tick, ordered by their exact cycle
+		std::deque<SchedulerTask*> m_readyList;
 };
 extern Scheduler g_scheduler;
 
@@ -100,7 +100,7 @@ void ServicePort::open(IPAddressList ips, uint16_t port)
 	{
 		m_logError = false;
 		m_pendingStart = true;
-		g_scheduler.addEvent(createSchedulerTask(5000, std::bind(
+		g_scheduler.addEvent(createSchedulerTaskWithOrigin("ServicePort::open", 5000, std::bind(
 			&ServicePort::services, std::weak_ptr<ServicePort>(shared_from_this()), pendingIps, m_serverPort)));
 	}
 }
@@ -194,7 +194,7 @@ void ServicePort::handle(Acceptor_ptr acceptor, boost::asio::ip::tcp::socket* so
 		if(!m_pendingStart)
 		{
 			m_pendingStart = true;
-			g_scheduler.addEvent(createSchedulerTask(5000, std::bind(
+			g_scheduler.addEvent(createSchedulerTaskWithOrigin("ServicePort::handle", 5000, std::bind(
 				&ServicePort::service, std::weak_ptr<ServicePort>(shared_from_this()),
 				acceptor->local_endpoint().address().to_v4(), m_serverPort)));
 		}
@@ -235,6 +235,21 @@ Protocol* ServicePort::makeProtocol(bool checksum, NetworkMessage& msg) const
 void ServiceManager::run()
 {
 	assert(!running);
+	//the calling thread is one of them, every connection serializes its own handlers on a strand
+	std::vector<std::thread> threads;
+	for(int32_t i = 1; i < g_config.getNumber(ConfigManager::NETWORK_THREADS); ++i)
+		threads.push_back(std::thread(&ServiceManager::runThread, this));
+
+	runThread();
+	for(std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		if(it->joinable())
+			it->join();
+	}
+}
+
+void ServiceManager::runThread()
+{
 	try
 	{
 		m_io_service.run();
@@ -121,6 +121,7 @@ class ServiceManager
 
 	protected:
 		void die() {m_io_service.stop();}
+		void runThread();
 
 		boost::asio::io_service m_io_service;
 		boost::asio::deadline_timer deathTimer;
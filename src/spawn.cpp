@@ -237,7 +237,7 @@ bool Spawns::isInZone(const Position& centerPos, int32_t radius, const Position&
 void Spawn::startEvent()
 {
 	if(!checkSpawnEvent)
-		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTask(getInterval(), std::bind(&Spawn::checkSpawn, this)));
+		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Spawn::startEvent", getInterval(), std::bind(&Spawn::checkSpawn, this)));
 }
 
 Spawn::Spawn(const Position& _pos, int32_t _radius)
@@ -269,7 +269,7 @@ Spawn::~Spawn()
 bool Spawn::findPlayer(const Position& pos)
 {
 	SpectatorVec list;
-	g_game.getSpectators(list, pos);
+	g_game.getPlayerSpectators(list, pos);
 
 	Player* tmpPlayer = NULL;
 	for(SpectatorVec::iterator it = list.begin(); it != list.end(); ++it)
@@ -362,7 +362,8 @@ void Spawn::checkSpawn()
 		if(OTSYS_TIME() < sb.lastSpawn + sb.interval)
 			continue;
 
-		if(findPlayer(sb.pos))
+		//no player can be around an inactive region, skip asking the map
+		if(g_game.getMap()->isRegionActive(sb.pos) && findPlayer(sb.pos))
 		{
 			sb.lastSpawn = OTSYS_TIME();
 			continue;
@@ -375,7 +376,7 @@ void Spawn::checkSpawn()
 	}
 
 	if(spawnedMap.size() < spawnMap.size())
-		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTask(getInterval(), std::bind(&Spawn::checkSpawn, this)));
+		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("Spawn::checkSpawn", getInterval(), std::bind(&Spawn::checkSpawn, this)));
 #ifdef __DEBUG_SPAWN__
 	else
 		std::clog << "[Notice] Spawn::checkSpawn stopped " << this << std::endl;
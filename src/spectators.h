@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __SPECTATORS__
+#define __SPECTATORS__
+
+class Creature;
+
+#define SPECTATOR_INLINE_SIZE 32
+
+// Contiguous creature list, the first SPECTATOR_INLINE_SIZE entries live
+// inside the object so most spectator lookups never allocate.
+class SpectatorVec
+{
+	public:
+		typedef Creature* value_type;
+		typedef Creature** iterator;
+		typedef Creature* const* const_iterator;
+
+		SpectatorVec(): m_data(m_inline), m_size(0), m_capacity(SPECTATOR_INLINE_SIZE) {}
+		SpectatorVec(const SpectatorVec& other): m_data(m_inline), m_size(0), m_capacity(SPECTATOR_INLINE_SIZE)
+			{append(other.begin(), other.end());}
+		~SpectatorVec() {if(m_data != m_inline) delete[] m_data;}
+
+		SpectatorVec& operator=(const SpectatorVec& other)
+		{
+			if(this != &other)
+			{
+				m_size = 0;
+				append(other.begin(), other.end());
+			}
+
+			return *this;
+		}
+
+		iterator begin() {return m_data;}
+		iterator end() {return m_data + m_size;}
+		const_iterator begin() const {return m_data;}
+		const_iterator end() const {return m_data + m_size;}
+
+		Creature* operator[](uint32_t index) const {return m_data[index];}
+
+		uint32_t size() const {return m_size;}
+		bool empty() const {return !m_size;}
+		void clear() {m_size = 0;}
+
+		void push_back(Creature* creature)
+		{
+			if(m_size == m_capacity)
+				reserve(m_capacity * 2);
+
+			m_data[m_size++] = creature;
+		}
+
+		void append(const_iterator first, const_iterator last)
+		{
+			uint32_t count = last - first;
+			if(m_size + count > m_capacity)
+				reserve(std::max(m_capacity * 2, m_size + count));
+
+			std::copy(first, last, m_data + m_size);
+			m_size += count;
+		}
+
+		void reserve(uint32_t capacity)
+		{
+			if(capacity <= m_capacity)
+				return;
+
+			Creature** data = new Creature*[capacity];
+			std::copy(m_data, m_data + m_size, data);
+			if(m_data != m_inline)
+				delete[] m_data;
+
+			m_data = data;
+			m_capacity = capacity;
+		}
+
+	protected:
+		Creature** m_data;
+		uint32_t m_size, m_capacity;
+		Creature* m_inline[SPECTATOR_INLINE_SIZE];
+};
+#endif
@@ -33,17 +33,22 @@ extern Game g_game;
 uint32_t ProtocolStatus::protocolStatusCount = 0;
 #endif
 IpConnectMap ProtocolStatus::ipConnectMap;
+std::mutex ProtocolStatus::ipConnectLock;
 
 void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 {
-	IpConnectMap::const_iterator it = ipConnectMap.find(getIP());
-	if(it != ipConnectMap.end() && OTSYS_TIME() < it->second + g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT))
 	{
-		getConnection()->close();
-		return;
+		std::lock_guard<std::mutex> lockClass(ipConnectLock);
+		IpConnectMap::const_iterator it = ipConnectMap.find(getIP());
+		if(it != ipConnectMap.end() && OTSYS_TIME() < it->second + g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT))
+		{
+			getConnection()->close();
+			return;
+		}
+
+		ipConnectMap[getIP()] = OTSYS_TIME();
 	}
 
-	ipConnectMap[getIP()] = OTSYS_TIME();
 	uint8_t type = msg.get<char>();
 	switch(type)
 	{
@@ -61,6 +61,7 @@ class ProtocolStatus : public Protocol
 
 	protected:
 		static IpConnectMap ipConnectMap;
+		static std::mutex ipConnectLock;
 		virtual void deleteProtocolTask();
 };
 
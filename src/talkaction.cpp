@@ -30,6 +30,7 @@
 #include "teleport.h"
 #include "status.h"
 #include "textlogger.h"
+#include "taskprofiler.h"
 
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
 	#include "outputmessage.h"
@@ -38,6 +39,10 @@
 	#include "manager.h"
 	#include "protocollogin.h"
 	#include "protocolold.h"
+	#include "dispatcher.h"
+	#include "pathfinding.h"
+	#include "cryptopool.h"
+	#include "netcrypto.h"
 #endif
 
 #include "configmanager.h"
@@ -408,6 +413,8 @@ bool TalkAction::loadFunction(const std::string& functionName)
 		m_function = ghost;
 	else if(m_functionName == "software")
 		m_function = software;
+	else if(m_functionName == "profiler")
+		m_function = profiler;
 	else
 	{
 		std::clog << "[Warning - TalkAction::loadFunction] Function \"" << m_functionName << "\" does not exist." << std::endl;
@@ -1238,6 +1245,21 @@ bool TalkAction::diagnostics(Creature* creature, const std::string&, const std::
 		<< "ProtocolOld: " << ProtocolOld::protocolOldCount << std::endl << std::endl;
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
 
+	//socket writes per online player per second, since the previous call
+	static int64_t lastWriteCheck = 0;
+	static uint64_t lastWrites = 0;
+
+	const ConnectionStats& connectionStats = Connection::getStats();
+	int64_t now = OTSYS_TIME();
+	uint64_t writes = connectionStats.writes;
+
+	double writeRate = 0.;
+	if(lastWriteCheck && now > lastWriteCheck && g_game.getPlayersOnline())
+		writeRate = (writes - lastWrites) * 1000. / (now - lastWriteCheck) / g_game.getPlayersOnline();
+
+	lastWriteCheck = now;
+	lastWrites = writes;
+
 	s.str("");
 	s << "Connections:" << std::endl
 		<< "--------------------" << std::endl
@@ -1245,7 +1267,84 @@ bool TalkAction::diagnostics(Creature* creature, const std::string&, const std::
 		<< "Total message pool: " << OutputMessagePool::getInstance()->getTotalMessageCount() << std::endl
 		<< "Auto message pool: " << OutputMessagePool::getInstance()->getAutoMessageCount() << std::endl
 		<< "Queued message pool: " << OutputMessagePool::getInstance()->getQueuedMessageCount() << std::endl
-		<< "Free message pool: " << OutputMessagePool::getInstance()->getAvailableMessageCount() << std::endl;
+		<< "Free message pool: " << OutputMessagePool::getInstance()->getAvailableMessageCount() << std::endl
+		<< "Socket writes: " << writes << " (" << connectionStats.messages << " messages)" << std::endl
+		<< "Writes per player per second: " << writeRate << std::endl
+		<< "XTEA/Adler-32 kernels: " << getNetCryptoKernel() << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
+	const CastStats& castStats = Player::castStats;
+	s.str("");
+	s << "Cast fan-out:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Captured updates: " << castStats.packets << " (" << castStats.bytes << " bytes)" << std::endl
+		<< "Viewer copies: " << castStats.copies << std::endl
+		<< "Slow viewers dropped: " << castStats.dropped << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
+	const CryptoStats& cryptoStats = g_cryptoPool.getStats();
+	uint64_t cryptoJobs = std::max((uint64_t)1, cryptoStats.jobs.load());
+	s.str("");
+	s << "Login decryption:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Worker threads: " << g_cryptoPool.getThreadCount() << std::endl
+		<< "Decrypted logins: " << cryptoStats.jobs << std::endl
+		<< "Dropped logins: " << cryptoStats.dropped << std::endl
+		<< "Queue size: " << cryptoStats.queueSize << " (peak " << cryptoStats.maxQueueSize << ")" << std::endl
+		<< "Average queue wait: " << cryptoStats.waitTime / cryptoJobs << " us" << std::endl
+		<< "Average decrypt time: " << cryptoStats.runTime / cryptoJobs << " us (max " << cryptoStats.maxRunTime << " us)" << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+	g_cryptoPool.resetMaxQueueSize();
+
+	const DispatcherStats& dispatcherStats = g_dispatcher.getStats();
+	s.str("");
+	s << "Dispatcher:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Executed tasks: " << dispatcherStats.tasks << std::endl
+		<< "Batches: " << dispatcherStats.batches << std::endl
+		<< "Wakeups: " << dispatcherStats.wakeups << std::endl
+		<< "Contention: " << dispatcherStats.contention << std::endl
+		<< "Queue size: " << dispatcherStats.queueSize << " (peak " << dispatcherStats.maxQueueSize << ")" << std::endl
+		<< "Task pool blocks: " << TaskPool::getBlockCount() << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+	g_dispatcher.resetMaxQueueSize();
+
+	const PathfindingStats& pathfindingStats = g_pathfinding.getStats();
+	s.str("");
+	s << "Pathfinding:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Worker threads: " << g_pathfinding.getThreadCount() << std::endl
+		<< "Searched paths: " << pathfindingStats.jobs << std::endl
+		<< "Dropped jobs: " << pathfindingStats.dropped << std::endl
+		<< "Queue size: " << pathfindingStats.queueSize << std::endl;
+
+	const FlowFieldStats& flowFieldStats = g_game.getMap()->getFlowFieldStats();
+	s << "Flow fields built: " << flowFieldStats.built << std::endl
+		<< "Flow field paths: " << flowFieldStats.paths << std::endl
+		<< "Flow field fallbacks: " << flowFieldStats.fallbacks << std::endl;
+
+	const MapCacheStats& mapCacheStats = Creature::getMapCacheStats();
+	s << "Walk cache full rebuilds: " << mapCacheStats.full << std::endl
+		<< "Walk cache field refreshes: " << mapCacheStats.partial << std::endl
+		<< "Walk cache tile updates: " << mapCacheStats.tiles << std::endl;
+
+	const RegionStats& regionStats = g_game.getMap()->getRegionStats();
+	s << "Regions activated: " << regionStats.activated << std::endl
+		<< "Creatures suspended: " << regionStats.suspended << std::endl
+		<< "Creatures woken: " << regionStats.woken << std::endl;
+
+	const ThinkStats& thinkStats = g_game.getThinkStats();
+	s << "Thinks at full rate: " << thinkStats.thinks[THINKTIER_FULL] << std::endl
+		<< "Thinks at edge rate: " << thinkStats.thinks[THINKTIER_EDGE] << std::endl
+		<< "Thinks at far rate: " << thinkStats.thinks[THINKTIER_FAR] << std::endl
+		<< "Skipped thinks: " << thinkStats.skipped << std::endl
+		<< "Tiles to clean: " << g_game.getDirtyTileCount() << std::endl;
+
+	const DecayStats& decayStats = g_game.getDecayStats();
+	s << "Decaying items: " << g_game.getDecayingCount() << std::endl
+		<< "Decays expired: " << decayStats.expired << std::endl
+		<< "Stale decay entries: " << decayStats.stale << std::endl
+		<< "Decay entries cascaded: " << decayStats.cascaded << std::endl;
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
 
 #else
@@ -1399,3 +1498,35 @@ bool TalkAction::software(Creature* creature, const std::string&, const std::str
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
 	return true;
 }
+
+bool TalkAction::profiler(Creature* creature, const std::string&, const std::string& param)
+{
+	Player* player = creature->getPlayer();
+	if(!player)
+		return false;
+
+	TaskProfiler* taskProfiler = TaskProfiler::getInstance();
+	std::string tmp = asLowerCaseString(param);
+	trimString(tmp);
+	if(tmp == "reset")
+	{
+		taskProfiler->reset();
+		player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, "Task profile has been reset.");
+	}
+	else if(tmp == "dump")
+	{
+		taskProfiler->dump();
+		player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, "Task profile has been written to the log.");
+	}
+	else if(tmp == "on" || tmp == "off")
+	{
+		taskProfiler->setEnabled(tmp == "on");
+		player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, std::string("Task profiler has been ") + (tmp == "on" ? "enabled." : "disabled."));
+	}
+	else if(!taskProfiler->isEnabled())
+		player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, "Task profiler is disabled, use \"on\" to enable it.");
+	else
+		player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, taskProfiler->getReport(10));
+
+	return true;
+}
@@ -106,6 +106,7 @@ class TalkAction : public Event
 		static TalkFunction addSkill;
 		static TalkFunction ghost;
 		static TalkFunction software;
+		static TalkFunction profiler;
 
 		std::string m_words, m_functionName;
 		TalkFunction* m_function;
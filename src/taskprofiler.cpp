@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "taskprofiler.h"
+#include "scheduler.h"
+
+#include "configmanager.h"
+#include "textlogger.h"
+#include "tools.h"
+
+extern ConfigManager g_config;
+
+TaskProfiler::TaskProfiler()
+{
+	m_enabled = false;
+	m_start = OTSYS_TIME();
+	m_logEvent = 0;
+}
+
+TaskProfiler::~TaskProfiler()
+{
+	if(m_writer.joinable())
+		m_writer.join();
+}
+
+uint32_t TaskHistogram::getBucket(uint64_t value)
+{
+	if(value < PROFILER_SUB_BUCKETS)
+		return value;
+
+	uint32_t exponent = 0;
+	for(uint64_t tmp = value; tmp >= PROFILER_SUB_BUCKETS * 2; tmp >>= 1)
+		++exponent;
+
+	uint32_t bucket = (exponent + 1) * PROFILER_SUB_BUCKETS + ((value >> exponent) & (PROFILER_SUB_BUCKETS - 1));
+	return std::min(bucket, (uint32_t)PROFILER_BUCKETS - 1);
+}
+
+uint64_t TaskHistogram::getBucketLimit(uint32_t bucket)
+{
+	if(bucket < PROFILER_SUB_BUCKETS)
+		return bucket;
+
+	uint32_t exponent = bucket / PROFILER_SUB_BUCKETS - 1;
+	return ((uint64_t)(PROFILER_SUB_BUCKETS + bucket % PROFILER_SUB_BUCKETS + 1) << exponent) - 1;
+}
+
+void TaskHistogram::add(uint64_t value)
+{
+	++m_buckets[getBucket(value)];
+	++m_count;
+
+	m_total += value;
+	if(value > m_max)
+		m_max = value;
+}
+
+void TaskHistogram::merge(const TaskHistogram& other)
+{
+	for(uint32_t i = 0; i < PROFILER_BUCKETS; ++i)
+		m_buckets[i] += other.m_buckets[i];
+
+	m_count += other.m_count;
+	m_total += other.m_total;
+	m_max = std::max(m_max, other.m_max);
+}
+
+void TaskHistogram::reset()
+{
+	std::fill(std::begin(m_buckets), std::end(m_buckets), 0);
+	m_count = m_total = m_max = 0;
+}
+
+uint64_t TaskHistogram::getPercentile(double percentile) const
+{
+	if(!m_count)
+		return 0;
+
+	uint64_t rank = std::max((uint64_t)1, (uint64_t)std::ceil(m_count * percentile / 100.)), seen = 0;
+	for(uint32_t i = 0; i < PROFILER_BUCKETS; ++i)
+	{
+		seen += m_buckets[i];
+		if(seen >= rank)
+			return std::min(getBucketLimit(i), m_max);
+	}
+
+	return m_max;
+}
+
+void TaskProfiler::record(const char* origin, int64_t wait, int64_t execution)
+{
+	TaskProfile& profile = m_profiles[origin];
+	profile.wait.add(std::max((int64_t)0, wait));
+	profile.execution.add(std::max((int64_t)0, execution));
+}
+
+void TaskProfiler::reset()
+{
+	m_profiles.clear();
+	m_start = OTSYS_TIME();
+}
+
+std::string TaskProfiler::getReport(const ProfileMap& profiles, int64_t start, uint32_t limit)
+{
+	typedef std::map<std::string, TaskProfile> NamedProfiles;
+	NamedProfiles named;
+	for(ProfileMap::const_iterator it = profiles.begin(); it != profiles.end(); ++it)
+	{
+		TaskProfile& profile = named[it->first];
+		profile.execution.merge(it->second.execution);
+		profile.wait.merge(it->second.wait);
+	}
+
+	// the most expensive origins go first
+	std::vector<NamedProfiles::const_iterator> sorted;
+	for(NamedProfiles::const_iterator it = named.begin(); it != named.end(); ++it)
+		sorted.push_back(it);
+
+	std::sort(sorted.begin(), sorted.end(), [](NamedProfiles::const_iterator a, NamedProfiles::const_iterator b) {
+		return a->second.execution.getTotal() > b->second.execution.getTotal();
+	});
+
+	if(limit && sorted.size() > limit)
+		sorted.resize(limit);
+
+	std::stringstream s;
+	s << "Task profile of the last " << (OTSYS_TIME() - start) / 1000 << " seconds (times in microseconds):" << std::endl;
+	for(std::vector<NamedProfiles::const_iterator>::const_iterator it = sorted.begin(); it != sorted.end(); ++it)
+	{
+		const TaskHistogram& execution = (*it)->second.execution;
+		const TaskHistogram& wait = (*it)->second.wait;
+		s << (*it)->first << ": " << execution.getCount() << " tasks, total " << execution.getTotal()
+			<< ", p50 " << execution.getPercentile(50) << ", p99 " << execution.getPercentile(99) << ", max " << execution.getMax()
+			<< " | wait p50 " << wait.getPercentile(50) << ", p99 " << wait.getPercentile(99) << ", max " << wait.getMax() << std::endl;
+	}
+
+	return s.str();
+}
+
+void TaskProfiler::dump()
+{
+	//the previous dump is long written by now, this does not block
+	if(m_writer.joinable())
+		m_writer.join();
+
+	ProfileMap profiles;
+	profiles.swap(m_profiles);
+
+	m_writer = std::thread(&TaskProfiler::writeReport, std::move(profiles), m_start);
+	m_start = OTSYS_TIME();
+}
+
+void TaskProfiler::writeReport(ProfileMap profiles, int64_t start)
+{
+	Logger::getInstance()->eFile("server/dispatcher.log", getReport(profiles, start, 0), false);
+}
+
+void TaskProfiler::startLogging()
+{
+	m_enabled = g_config.getBool(ConfigManager::DISPATCHER_PROFILER);
+	if(m_logEvent)
+	{
+		g_scheduler.stopEvent(m_logEvent);
+		m_logEvent = 0;
+	}
+
+	if(m_enabled && g_config.getNumber(ConfigManager::DISPATCHER_PROFILER_INTERVAL) > 0)
+		m_logEvent = g_scheduler.addEvent(createSchedulerTaskWithOrigin("TaskProfiler::startLogging", g_config.getNumber(ConfigManager::DISPATCHER_PROFILER_INTERVAL) * 1000,
+			std::bind(&TaskProfiler::logReport, this)));
+}
+
+void TaskProfiler::logReport()
+{
+	m_logEvent = 0;
+	dump();
+	startLogging();
+}
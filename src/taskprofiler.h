@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef __TASK_PROFILER__
+#define __TASK_PROFILER__
+
+// log2 buckets split in 4 linear steps, values are in microseconds
+#define PROFILER_SUB_BUCKETS 4
+#define PROFILER_BUCKETS 128
+
+class TaskHistogram
+{
+	public:
+		TaskHistogram() {reset();}
+
+		void add(uint64_t value);
+		void merge(const TaskHistogram& other);
+		void reset();
+
+		uint64_t getCount() const {return m_count;}
+		uint64_t getTotal() const {return m_total;}
+		uint64_t getMax() const {return m_max;}
+		uint64_t getPercentile(double percentile) const;
+
+	protected:
+		static uint32_t getBucket(uint64_t value);
+		static uint64_t getBucketLimit(uint32_t bucket);
+
+		uint64_t m_buckets[PROFILER_BUCKETS];
+		uint64_t m_count, m_total, m_max;
+};
+
+struct TaskProfile
+{
+	TaskHistogram execution, wait;
+};
+
+// Collects the execution and queue wait times of dispatcher tasks grouped by
+// the function that created them. Only the dispatcher thread touches it.
+class TaskProfiler
+{
+	public:
+		virtual ~TaskProfiler();
+		static TaskProfiler* getInstance()
+		{
+			static TaskProfiler instance;
+			return &instance;
+		}
+
+		static int64_t getTime()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		bool isEnabled() const {return m_enabled;}
+		void setEnabled(bool enabled) {m_enabled = enabled;}
+
+		void record(const char* origin, int64_t wait, int64_t execution);
+		void reset();
+
+		std::string getReport(uint32_t limit = 0) const {return getReport(m_profiles, m_start, limit);}
+		// hands the profile to a writer thread and starts a new one
+		void dump();
+
+		void startLogging();
+
+	protected:
+		TaskProfiler();
+		void logReport();
+
+		// literals with the same name may live in different translation units,
+		// they are merged by name when the report is built
+		typedef std::unordered_map<const char*, TaskProfile> ProfileMap;
+		ProfileMap m_profiles;
+
+		static std::string getReport(const ProfileMap& profiles, int64_t start, uint32_t limit);
+		static void writeReport(ProfileMap profiles, int64_t start);
+
+		std::atomic<bool> m_enabled;
+		int64_t m_start;
+		uint32_t m_logEvent;
+		// formats and writes the dumped profile, the dispatcher does not wait for the disk
+		std::thread m_writer;
+};
+#endif
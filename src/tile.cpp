@@ -18,6 +18,7 @@
 #include "otpch.h"
 
 #include "tile.h"
+#include "networkmessage.h"
 #include "housetile.h"
 
 #include "player.h"
@@ -353,9 +354,18 @@ const Creature* Tile::getTopVisibleCreature(const Creature* creature) const
 	return NULL;
 }
 
+static inline bool isCleanable(const Item* item)
+{
+	return item->isMovable() && !item->isLoadedFromMap();
+}
+
 void Tile::onAddTileItem(Item* item)
 {
+	resetDescription();
 	updateTileFlags(item, false);
+	if(isCleanable(item))
+		g_game.addDirtyTile(pos);
+
 	const Position& cylinderMapPos = pos;
 
 	const SpectatorVec& list = g_game.getSpectators(cylinderMapPos);
@@ -376,6 +386,10 @@ void Tile::onAddTileItem(Item* item)
 
 void Tile::onUpdateTileItem(Item* oldItem, const ItemType& oldType, Item* newItem, const ItemType& newType)
 {
+	resetDescription();
+	if((oldType.movable && !oldItem->isLoadedFromMap()) || isCleanable(newItem))
+		updateDirtyState();
+
 	const Position& cylinderMapPos = pos;
 
 	const SpectatorVec& list = g_game.getSpectators(cylinderMapPos);
@@ -396,7 +410,11 @@ void Tile::onUpdateTileItem(Item* oldItem, const ItemType& oldType, Item* newIte
 
 void Tile::onRemoveTileItem(const SpectatorVec& list, std::vector<uint32_t>& oldStackposVector, Item* item)
 {
+	resetDescription();
 	updateTileFlags(item, true);
+	if(isCleanable(item))
+		updateDirtyState();
+
 	const Position& cylinderMapPos = pos;
 
 	const ItemType& iType = Item::items[item->getID()];
@@ -418,6 +436,7 @@ void Tile::onRemoveTileItem(const SpectatorVec& list, std::vector<uint32_t>& old
 
 void Tile::onUpdateTile()
 {
+	resetDescription();
 	const Position& cylinderMapPos = pos;
 
 	const SpectatorVec& list = g_game.getSpectators(cylinderMapPos);
@@ -466,6 +485,7 @@ void Tile::moveCreature(Creature* actor, Creature* creature, Cylinder* toCylinde
 	{
 		qt_node->removeCreature(creature);
 		newTile->qt_node->addCreature(creature);
+		g_game.getMap()->onCreatureChangeLeaf(creature, pos, newPos);
 	}
 
 	//add the creature
@@ -864,13 +884,16 @@ void Tile::__addThing(Creature* actor, int32_t, Thing* thing)
 {
 	if(Creature* creature = thing->getCreature())
 	{
-		g_game.clearSpectatorCache();
+		if(qt_node)
+			qt_node->onCreatureChange(creature);
+
 		creature->setParent(this);
 
 		CreatureVector* creatures = makeCreatures();
 		creatures->insert(creatures->begin(), creature);
 
 		++thingCount;
+		updateWalkBits();
 		return;
 	}
 
@@ -1153,9 +1176,12 @@ void Tile::__removeThing(Thing* thing, uint32_t count)
 				return/* RET_NOTPOSSIBLE*/;
 			}
 
-			g_game.clearSpectatorCache();
+			if(qt_node)
+				qt_node->onCreatureChange(creature);
+
 			creatures->erase(it);
 			--thingCount;
+			updateWalkBits();
 		}
 #ifdef __DEBUG_MOVESYS__
 		else
@@ -1533,11 +1559,14 @@ void Tile::__internalAddThing(uint32_t, Thing* thing)
 	thing->setParent(this);
 	if(Creature* creature = thing->getCreature())
 	{
-		g_game.clearSpectatorCache();
+		if(qt_node)
+			qt_node->onCreatureChange(creature);
+
 		CreatureVector* creatures = makeCreatures();
 		creatures->insert(creatures->begin(), creature);
 
 		++thingCount;
+		updateWalkBits();
 		return;
 	}
 
@@ -1549,6 +1578,7 @@ void Tile::__internalAddThing(uint32_t, Thing* thing)
 	if(items && items->size() >= 0xFFFF)
 		return/* RET_NOTPOSSIBLE*/;
 
+	resetDescription();
 	if(item->isGroundTile())
 	{
 		if(!ground)
@@ -1586,6 +1616,99 @@ void Tile::__internalAddThing(uint32_t, Thing* thing)
 	}
 
 	updateTileFlags(item, false);
+	if(isCleanable(item))
+		g_game.addDirtyTile(pos);
+}
+
+PathState_t Tile::getPathState(const Creature* creature) const
+{
+	Floor* floor = (qt_node ? qt_node->getFloor(pos.z) : NULL);
+	if(!floor)
+		return PATHSTATE_CHECK;
+
+	PathState_t state = floor->getPathState(pos.x & FLOOR_MASK, pos.y & FLOOR_MASK);
+	if(state == PATHSTATE_FREE && isLeavingHardcoreZone(creature))
+		return PATHSTATE_CHECK;
+
+	return state;
+}
+
+bool Tile::isLeavingHardcoreZone(const Creature* creature)
+{
+	const Player* player = (creature ? creature->getPlayer() : NULL);
+	if(!player || !player->isPzLocked())
+		return false;
+
+	const Tile* tile = player->getTile();
+	return tile && tile->hasFlag(TILESTATE_HARDCOREZONE);
+}
+
+void Tile::updateWalkBits()
+{
+	if(!qt_node)
+		return;
+
+	if(Floor* floor = qt_node->getFloor(pos.z))
+		floor->updateBits(pos.x & FLOOR_MASK, pos.y & FLOOR_MASK, this);
+}
+
+void Tile::updateDirtyState()
+{
+	if(const TileItemVector* items = getItemList())
+	{
+		for(ItemVector::const_iterator it = items->begin(); it != items->end(); ++it)
+		{
+			if(isCleanable(*it))
+			{
+				g_game.addDirtyTile(pos);
+				return;
+			}
+		}
+	}
+
+	g_game.removeDirtyTile(pos);
+}
+
+const uint8_t* Tile::getDescription() const
+{
+	if(m_description)
+		return m_description;
+
+	static NetworkMessage msg;
+	msg.reset(0);
+
+	uint8_t topCount = 0, downCount = 0, downEnds[10];
+	if(ground)
+	{
+		msg.putItem(ground);
+		++topCount;
+	}
+
+	const TileItemVector* items = getItemList();
+	if(items)
+	{
+		for(ItemVector::const_iterator it = items->getBeginTopItem(); it != items->getEndTopItem() && topCount < 10; ++it, ++topCount)
+			msg.putItem(*it);
+	}
+
+	uint8_t topSize = msg.size();
+	if(items)
+	{
+		for(ItemVector::const_iterator it = items->getBeginDownItem(); it != items->getEndDownItem() && topCount + downCount < 10; ++it)
+		{
+			msg.putItem(*it);
+			downEnds[downCount++] = msg.size() - topSize;
+		}
+	}
+
+	m_description = new uint8_t[TILEDESC_DOWNENDS + downCount + msg.size()];
+	m_description[TILEDESC_TOPCOUNT] = topCount;
+	m_description[TILEDESC_DOWNCOUNT] = downCount;
+	m_description[TILEDESC_TOPSIZE] = topSize;
+
+	memcpy(m_description + TILEDESC_DOWNENDS, downEnds, downCount);
+	memcpy(m_description + TILEDESC_DOWNENDS + downCount, msg.buffer(), msg.size());
+	return m_description;
 }
 
 void Tile::updateTileFlags(Item* item, bool remove)
@@ -1681,6 +1804,9 @@ void Tile::updateTileFlags(Item* item, bool remove)
 
 		if(item->hasProperty(IMMOVABLENOFIELDBLOCKPATH))
 			setFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH);
+
+		if(item->hasProperty(BLOCKPROJECTILE))
+			setFlag(TILESTATE_BLOCKPROJECTILE);
 	}
 	else
 	{
@@ -1773,5 +1899,10 @@ void Tile::updateTileFlags(Item* item, bool remove)
 
 		if(item->hasProperty(IMMOVABLENOFIELDBLOCKPATH) && !hasProperty(item, IMMOVABLENOFIELDBLOCKPATH))
 			resetFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH);
+
+		if(item->hasProperty(BLOCKPROJECTILE) && !hasProperty(item, BLOCKPROJECTILE))
+			resetFlag(TILESTATE_BLOCKPROJECTILE);
 	}
+
+	updateWalkBits();
 }
@@ -20,6 +20,7 @@
 
 #include "cylinder.h"
 #include "item.h"
+#include "spectators.h"
 
 class Teleport;
 class TrashHolder;
@@ -33,9 +34,7 @@ class HouseTile;
 class QTreeLeafNode;
 
 typedef std::list<Player*> PlayerList;
-typedef std::list<Creature*> SpectatorVec;
 typedef std::vector<Creature*> CreatureVector;
-typedef std::map<Position, std::shared_ptr<SpectatorVec> > SpectatorCache;
 
 enum tileflags_t
 {
@@ -71,7 +70,8 @@ enum tileflags_t
 	TILESTATE_IMMOVABLEBLOCKPATH = 1 << 26,
 	TILESTATE_IMMOVABLENOFIELDBLOCKPATH = 1 << 27,
 	TILESTATE_NOFIELDBLOCKPATH = 1 << 28,
-	TILESTATE_DYNAMIC_TILE = 1 << 29
+	TILESTATE_DYNAMIC_TILE = 1 << 29,
+	TILESTATE_BLOCKPROJECTILE = 1 << 30
 };
 
 enum ZoneType_t
@@ -83,6 +83,23 @@ enum ZoneType_t
 	ZONE_OPEN
 };
 
+// what the floor bit layers tell about a creature pathing onto a tile
+enum PathState_t
+{
+	PATHSTATE_BLOCKED = 0, // ground missing, floor change or teleport, nobody may
+	PATHSTATE_FREE = 1, // nothing on it that any creature could care about
+	PATHSTATE_CHECK = 2 // depends on the creature, ask __queryAdd
+};
+
+// layout of Tile::getDescription, the item bytes follow the down item ends
+enum TileDescription_t
+{
+	TILEDESC_TOPCOUNT = 0, // ground and top items written
+	TILEDESC_DOWNCOUNT = 1, // down items written, at most 10 things with the top ones
+	TILEDESC_TOPSIZE = 2, // bytes of the ground and top items
+	TILEDESC_DOWNENDS = 3 // end of each down item, from the first down item
+};
+
 class TileItemVector
 {
 	public:
@@ -154,6 +171,21 @@ class Tile : public Cylinder
 		const HouseTile* getHouseTile() const;
 		bool isHouseTile() const {return hasFlag(TILESTATE_HOUSE);}
 
+		// creature is the one pathing, the state of some tiles depends on where it stands
+		PathState_t getPathState(const Creature* creature) const;
+		// a pz-locked player on a hardcore tile may not step off the zone, so to it
+		// no tile outside the zone is PATHSTATE_FREE
+		static bool isLeavingHardcoreZone(const Creature* creature);
+		// refreshes the bits of this tile in its floor, after flags or creatures changed
+		void updateWalkBits();
+		// adds or drops this tile in the Game index of tiles to clean
+		void updateDirtyState();
+
+		// the ground and items serialized as map descriptions send them, built
+		// on demand and dropped whenever a client is told that they changed
+		const uint8_t* getDescription() const;
+		void resetDescription() {delete[] m_description; m_description = NULL;}
+
 		MagicField* getFieldItem() const;
 		Teleport* getTeleportItem() const;
 		TrashHolder* getTrashHolder() const;
@@ -291,6 +323,7 @@ class Tile : public Cylinder
 	protected:
 		Position pos;
 		uint32_t m_flags, thingCount;
+		mutable uint8_t* m_description;
 };
 
 // Used for walkable tiles, where there is high likeliness of
@@ -333,9 +366,9 @@ class StaticTile : public Tile
 };
 
 inline Tile::Tile(uint16_t x, uint16_t y, uint16_t z): qt_node(NULL),
-	ground(NULL), pos(x, y, z), m_flags(0), thingCount(0) {}
+	ground(NULL), pos(x, y, z), m_flags(0), thingCount(0), m_description(NULL) {}
 
-inline Tile::~Tile() {}
+inline Tile::~Tile() {delete[] m_description;}
 
 inline CreatureVector* Tile::getCreatures()
 {
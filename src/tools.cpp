@@ -21,9 +21,9 @@
 #define CRYPTOPP_DEFAULT_NO_DLL
 
 #include "tools.h"
+#include "netcrypto.h"
 #include <cryptopp/sha.h>
 #include <cryptopp/md5.h>
-#include <cryptopp/adler32.h>
 #include <cryptopp/hmac.h>
 
 #include <cryptopp/hex.h>
@@ -1974,15 +1974,7 @@ uint32_t adlerChecksum(uint8_t* data, size_t length)
 	if(length > NETWORK_MAX_SIZE || !length)
 		return 0;
 
-	// Crypto++ object
-	CryptoPP::Adler32 adler;
-	// Digest cash object, cast later
-	byte digest[CryptoPP::Adler32::DIGESTSIZE];
-
-	// Do the calculation now
-	adler.CalculateDigest(digest, (const byte*)data, length);
-	// return uint32_t cast type
-	return (uint32_t)(((uint16_t)digest[0] << 8 | digest[1]) << 16) | ((uint16_t)digest[2] << 8 | digest[3]);
+	return adler32(data, length);
 }
 
 std::string getFilePath(FileType_t type, std::string name/* = ""*/)